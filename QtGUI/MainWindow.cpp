@@ -172,7 +172,7 @@ void MainWindow::refreshUI() {
     ui->defaultTerrainLabel->setEnabled(isKMZ);
     ui->meterLabel->setEnabled(isKMZ);
     ui->qnhLabel->setEnabled(airspaceOutput);
-    ui->QNHspinBox->setEnabled(airspaceOutput && converter->GetNumOfAirspaces()==0);
+    ui->QNHspinBox->setEnabled(airspaceOutput);
     ui->hPaLabel->setEnabled(airspaceOutput);
     ui->onlyPointsCheckBox->setEnabled(isOpenAir);
     ui->openAirCoordinateTypeComboBox->setEnabled(isOpenAir);
@@ -432,7 +432,10 @@ void MainWindow::on_convertButton_clicked() {
     startBusy();
 
     // Set default terrain altitude
-    AirspaceConverter::SetDefaultTerrainAlt(ui->defaultAltSpinBox->value());
+    converter->SetDefaultTerrainAlt(ui->defaultAltSpinBox->value());
+
+    // Set QNH, also on the airspaces already loaded
+    converter->SetQNH(ui->QNHspinBox->value());
 
     // Set OpenAir settings
     converter->DoNotCalculateArcsAndCirconferences(ui->onlyPointsCheckBox->isChecked());
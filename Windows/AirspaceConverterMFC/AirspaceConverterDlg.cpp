@@ -418,7 +418,7 @@ void CAirspaceConverterDlg::EndBusy(const bool takeTime /* = false */) {
 	filterBt.EnableWindow(numAirspacesLoaded > 0 || numWaypointsLoaded > 0);
 	ConvertBt.EnableWindow(numAirspacesLoaded > 0 || ((isKmzFile || isWaypointFile) && numWaypointsLoaded > 0));
 	OutputTypeCombo.EnableWindow(TRUE);
-	editQNHtextField.EnableWindow(isKmzFile ? numAirspacesLoaded == 0 : FALSE);
+	editQNHtextField.EnableWindow(isKmzFile);
 	editDefualtAltTextField.EnableWindow(isKmzFile);
 	pointsCheckBox.EnableWindow(isOpenAirFile);
 	OpenAirCoordinateFormatCombo.EnableWindow(isOpenAirFile);
@@ -621,7 +621,7 @@ void CAirspaceConverterDlg::OnBnClickedOutputTypeCombo() {
 	LoadAirspacesFolderBt.EnableWindow(!isWaypointFile);
 	loadWaypointsFolderBt.EnableWindow(isKmzFile || isWaypointFile);
 	LoadRasterMapsFolderBt.EnableWindow(isKmzFile || isWaypointFile);
-	editQNHtextField.EnableWindow(isKmzFile ? numAirspacesLoaded == 0 : FALSE);
+	editQNHtextField.EnableWindow(isKmzFile);
 	editDefualtAltTextField.EnableWindow(isKmzFile);
 	pointsCheckBox.EnableWindow(isOpenAirFile);
 	OpenAirCoordinateFormatCombo.EnableWindow(isOpenAirFile);
@@ -630,7 +630,7 @@ void CAirspaceConverterDlg::OnBnClickedOutputTypeCombo() {
 }
 
 void CAirspaceConverterDlg::OnBnClickedConvert() {
-	if (!UpdateData(TRUE)) return; // Force the user to enter valid default terrain altitude
+	if (!UpdateData(TRUE)) return; // Force the user to enter valid default terrain altitude and QNH
 	assert(!outputFile.empty());
 	
 	// Prepare and show the open file dialog asking where the user wants to save the converted file
@@ -678,7 +678,8 @@ void CAirspaceConverterDlg::OnBnClickedConvert() {
 				else return;
 			}
 		}
-		AirspaceConverter::SetDefaultTerrainAlt(defaultTerrainAlt);
+		converter->SetDefaultTerrainAlt(defaultTerrainAlt);
+		converter->SetQNH(QNH);
 		if (processor != nullptr && processor->Convert()) StartBusy();
 		else MessageBox(_T("Error while starting KML output thread."), _T("Error"), MB_ICONERROR);
 		break;
@@ -11,12 +11,39 @@
 //============================================================================
 
 #include "Airspace.hpp"
+#include "Parallel.hpp"
 #include <algorithm>
 #include <cassert>
 #include <iomanip>
+#include <format>
+#include <unordered_set>
+#include <numeric>
+#include <map>
+#include <tuple>
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized" // False positive in the envelope of multi geometries used by union_
+#endif
 #include <boost/geometry.hpp>
 #include <boost/geometry/geometries/polygon.hpp>
+#include <boost/geometry/geometries/box.hpp>
+#include <boost/geometry/geometries/multi_polygon.hpp>
+#include <boost/geometry/geometries/point_xy.hpp>
 #include <boost/geometry/geometries/adapted/boost_tuple.hpp>
+#include <boost/geometry/index/rtree.hpp>
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+// Geometries on the lat/lon plane, with longitude as x and latitude as y, used to cut, merge and intersect the borders
+typedef boost::geometry::model::d2::point_xy<double> PointXY;
+typedef boost::geometry::model::polygon<PointXY> PolygonXY;
+typedef boost::geometry::model::multi_polygon<PolygonXY> MultiPolygonXY;
+typedef boost::geometry::model::box<PointXY> BoxXY;
+typedef boost::geometry::model::polygon<boost::geometry::model::point<double, 2, boost::geometry::cs::geographic<boost::geometry::degree>>> GeographicPolygon;
+
+// Geographic strategy with WGS84 spheroid (spheroid sizes in Km)
+static const boost::geometry::strategy::area::geographic<> wgs84(boost::geometry::srs::spheroid<double>(6378.137, 6356.7523142451793));
 
 const bool Airspace::CATEGORY_VISIBILITY[Airspace::UNDEFINED] = {
 	false,	//CLASSA
@@ -71,6 +98,10 @@ const bool Airspace::CATEGORY_VISIBILITY[Airspace::UNDEFINED] = {
 	false	//UNKNOWN
 };
 
+const std::shared_ptr<std::vector<std::shared_ptr<const Geometry>>> Airspace::NO_GEOMETRIES = std::make_shared<std::vector<std::shared_ptr<const Geometry>>>();
+
+const std::shared_ptr<std::vector<Geometry::LatLon>> Airspace::NO_POINTS = std::make_shared<std::vector<Geometry::LatLon>>();
+
 const std::string Airspace::CATEGORY_NAMES[Airspace::UNDEFINED] = {
 	"Class A",
 	"Class B",
@@ -178,46 +209,85 @@ const std::string Airspace::LONG_CATEGORY_NAMES[Airspace::UNDEFINED] = {
 };
 
 Airspace::Airspace(Type category)
-	: type(category)
+	: geometries(NO_GEOMETRIES)
+	, points(NO_POINTS)
+	, type(category)
 	, airspaceClass(category >= CLASSA && category <= CLASSG ? category : UNDEFINED)
-	, transponderCode(-1) {
+	, transponderCode(-1)
+	, sourceLine(-1)
+	, areaKm2(-1)
+	, perimeterKm(-1)
+	, surfaceOnSphere(false) {
 }
 
-Airspace::Airspace(const Airspace& orig) // Copy constructor
+Airspace::Airspace(const Airspace& orig) // Copy constructor, private: the points and the geometries are shared
 	: top(orig.top)
 	, base(orig.base)
 	, geometries(orig.geometries)
 	, points(orig.points)
+	, arena(orig.arena)
 	, type(orig.type)
 	, airspaceClass(orig.airspaceClass)
 	, name(orig.name)
 	, radioFrequencies(orig.radioFrequencies)
-	, transponderCode(orig.transponderCode) {
+	, transponderCode(orig.transponderCode)
+	, sourceFile(orig.sourceFile)
+	, sourceLine(orig.sourceLine)
+	, areaKm2(-1)
+	, perimeterKm(-1)
+	, surfaceOnSphere(false) {
 }
 
-Airspace::Airspace(Airspace&& orig) // Move constructor
+Airspace::Airspace(Airspace&& orig) noexcept // Move constructor
 	: top(std::move(orig.top))
 	, base(std::move(orig.base))
 	, geometries(std::move(orig.geometries))
 	, points(std::move(orig.points))
+	, arena(orig.arena)
 	, type(std::move(orig.type))
 	, airspaceClass(std::move(orig.airspaceClass))
 	, name(std::move(orig.name))
 	, radioFrequencies(std::move(orig.radioFrequencies))
-	, transponderCode(std::move(orig.transponderCode)) {
+	, transponderCode(std::move(orig.transponderCode))
+	, sourceFile(std::move(orig.sourceFile))
+	, sourceLine(orig.sourceLine)
+	, edgeTable(std::move(orig.edgeTable)) // The values calculated are still valid for the same points
+	, areaKm2(orig.areaKm2)
+	, perimeterKm(orig.perimeterKm)
+	, surfaceOnSphere(orig.surfaceOnSphere)
+	, boundingBox(orig.boundingBox) {
+	orig.geometries = NO_GEOMETRIES;
+	orig.points = NO_POINTS;
+	orig.PointsChanged();
+	orig.name = InternedString();
 	orig.type = UNDEFINED;
 }
 
-Airspace& Airspace::operator=(const Airspace& other) {
-	top = other.top;
-	base = other.base;
-	geometries = other.geometries;
-	points = other.points;
+Airspace& Airspace::operator=(Airspace&& other) noexcept {
+	if (this == &other) return *this;
+	PointsChanged();
+	top = std::move(other.top);
+	base = std::move(other.base);
+	geometries = std::move(other.geometries);
+	points = std::move(other.points);
+	arena = other.arena;
 	type = other.type;
 	airspaceClass = other.airspaceClass;
-	name = other.name;
-	radioFrequencies = other.radioFrequencies;
+	name = std::move(other.name);
+	radioFrequencies = std::move(other.radioFrequencies);
 	transponderCode = other.transponderCode;
+	sourceFile = std::move(other.sourceFile);
+	sourceLine = other.sourceLine;
+	edgeTable = std::move(other.edgeTable); // The values calculated are still valid for the same points
+	areaKm2 = other.areaKm2;
+	perimeterKm = other.perimeterKm;
+	surfaceOnSphere = other.surfaceOnSphere;
+	boundingBox = other.boundingBox;
+	other.geometries = NO_GEOMETRIES;
+	other.points = NO_POINTS;
+	other.PointsChanged();
+	other.name = InternedString();
+	other.type = UNDEFINED;
 	return *this;
 }
 
@@ -226,11 +296,7 @@ bool Airspace::operator==(const Airspace& other) const {
 	if (base != other.base) return false;
 	if (type != other.type) return false;
 	if (airspaceClass != other.airspaceClass) return false;
-	return points == other.points;
-}
-
-Airspace::~Airspace() {
-	ClearGeometries();
+	return *points == *other.points;
 }
 
 void Airspace::SetType(const Type& category) {
@@ -246,7 +312,7 @@ void Airspace::SetClass(const Type& airspClass) {
 
 void Airspace::AddRadioFrequency(const int frequencyHz, const std::string& description) {
 	assert(frequencyHz > 0);
-	radioFrequencies.push_back(std::make_pair(frequencyHz,description)); // here we expect already validated airband radio frequencies
+	radioFrequencies.push_back(std::make_pair(frequencyHz, InternedString(description))); // here we expect already validated airband radio frequencies
 }
 
 bool Airspace::SetTransponderCode(const std::string& code) {
@@ -270,6 +336,7 @@ std::string Airspace::GetTransponderCode() const {
 bool Airspace::GuessClassFromName() {
 	if (type != CTR && type != TMA && type != UNDEFINED) return false;
 	if (name.empty()) return false;
+	std::string text(name.Get());
 	Type foundClass = UNDEFINED;
 	const static std::vector<std::string> keywords = {
 		"Airspace class",
@@ -284,22 +351,22 @@ bool Airspace::GuessClassFromName() {
 		"Classe",
 		"CLASSE"
 	};
-	std::string::size_type nameLength = name.length();
+	std::string::size_type nameLength = text.length();
 	std::string::size_type start = 0, length = 0;
 	for(const std::string& keyword : keywords) {
-		start = name.find(keyword);
+		start = text.find(keyword);
 		if(start == std::string::npos) continue;
 		std::string::size_type pos = start + keyword.length();
 		if (nameLength <= pos) continue;
-		char c = name.at(pos);
+		char c = text.at(pos);
 		if (c == ' ' || c == ':') {
 			pos++;
 			if (nameLength <= pos) continue;
-			c = name.at(pos);
+			c = text.at(pos);
 			if (c == ' ' || c == ':') {
 				pos++;
 				if (nameLength <= pos) continue;
-				c = name.at(pos);
+				c = text.at(pos);
 			}
 		}
 		if (c >= 'A' && c <= 'F') {
@@ -320,23 +387,24 @@ bool Airspace::GuessClassFromName() {
 	if (type == UNDEFINED) type = foundClass;
 	
 	// Remove the text "Class: C" from the name
-	name.erase(start, length);
+	text.erase(start, length);
 
 	// Remove the eventual dash
-	if (name.length() >=3 && name.compare(name.length() - 3, 3, " - ") == 0) name.erase(name.length() - 3, 3);
+	if (text.length() >=3 && text.compare(text.length() - 3, 3, " - ") == 0) text.erase(text.length() - 3, 3);
+	name = InternedString(text);
 
 	return true;
 }
 
 bool Airspace::NameStartsWithIdent(const std::string& ident) {
-	if(name.length() < 4 || ident.length() < 4) return false;
-	return(ident.find(name.substr(0,4)) != std::string::npos);
+	if(name.size() < 4 || ident.length() < 4) return false;
+	return(ident.find(name.Get().substr(0,4)) != std::string::npos);
 }
 
 void Airspace::Clear() {
 	type = UNDEFINED;
 	airspaceClass = UNDEFINED;
-	name.clear();
+	name = InternedString();
 	ClearPoints();
 	radioFrequencies.clear();
 	transponderCode = -1;
@@ -344,139 +412,165 @@ void Airspace::Clear() {
 
 void Airspace::ClearPoints() {
 	ClearGeometries();
-	points.clear();
+	points = NO_POINTS;
 }
 
 void Airspace::ClearGeometries() {
-	if (geometries.empty()) return;
-	for (const Geometry* g : geometries) delete g;
-	geometries.clear();
+	PointsChanged(); // Called also when the points change
+	geometries = NO_GEOMETRIES;
+}
+
+// Get the points to change them, copying them first if shared with other airspaces
+std::vector<Geometry::LatLon>& Airspace::EditPoints() {
+	PointsChanged();
+	if (points.use_count() > 1) points = std::make_shared<std::vector<Geometry::LatLon>>(*points);
+	return *points;
+}
+
+// Get the geometries to change them, copying first the list if shared with other airspaces
+std::vector<std::shared_ptr<const Geometry>>& Airspace::EditGeometries() {
+	if (geometries.use_count() > 1) geometries = std::make_shared<std::vector<std::shared_ptr<const Geometry>>>(*geometries);
+	return *geometries;
 }
 
 bool Airspace::AddPoint(const Geometry::LatLon& point) {
 	// Make sure the point is not a duplicate of the last, not necessary to add it
-	if (!points.empty() && points.back() == point) return false;
+	if (!points->empty() && points->back() == point) return false;
 
 	// Make the new single "Point" geometry
-	geometries.push_back(new Point(point));
+	AppendGeometry<Point>(point);
 
 	// Add the point
-	points.push_back(point);
+	EditPoints().push_back(point);
+	PointsChanged();
 
 	return true;
 }
 
+void Airspace::DiscretizeGeometries(const size_t first, const double resolution) {
+	if (first >= geometries->size()) return;
+	std::vector<Geometry::LatLon>& output(EditPoints());
+	for (size_t i = first; i < geometries->size(); i++) (*geometries)[i]->Discretize(output, resolution);
+	PointsChanged();
+}
+
 bool Airspace::AddPointLatLonOnly(const double& lat, const double& lon) {
 	const Geometry::LatLon point(lat, lon);
 
 	// Make sure the point is not a duplicate or very similar to the last, not necessary to add it
-	if (!points.empty() && point.IsAlmostEqual(points.back())) return false;
+	if (!points->empty() && point.IsAlmostEqual(points->back())) return false;
 
 	// Add the point
-	points.push_back(point);
+	EditPoints().push_back(point);
+	PointsChanged();
 
 	return true;
 }
 
 bool Airspace::AddPointGeometryOnly(const Geometry::LatLon& point) {
 	// Make sure the point is not a duplicate of the last, not necessary to add it
-	if (!geometries.empty() && geometries.back()->IsPoint() && geometries.back()->GetCenterPoint() == point) return false;
+	if (!geometries->empty() && geometries->back()->IsPoint() && geometries->back()->GetCenterPoint() == point) return false;
 	
 	// Make the new single "Point" geometry
-	geometries.push_back(new Point(point));
+	AppendGeometry<Point>(point);
 
 	return true;
 }
 
 bool Airspace::ArePointsValid() const {
 	// The number of points must be at least 3+1 (plus the closing one)
-	assert(points.size() > 3);
+	assert(points->size() > 3);
 	
 	// Check if it is closed
-	if (points.front() != points.back()) return false;
+	if (points->front() != points->back()) return false;
 
 	// Except last one the points must be different from each other
-	const size_t l = points.size() - 1;
+	const size_t l = points->size() - 1;
 
-	// Using a set with O(N log N) is faster in the generic case, but here this way should be faster in most of cases and requiring less memory
-	for (size_t i = 0; i < l; i++) for (size_t j = i+1; j < l; j++) {
-		if (points.at(i) == points.at(j)) return false;
+	// For small polygons the simple comparison of all the couples is faster and requires no memory
+	static const size_t maxPointsToCompareAll = 32;
+	if (l <= maxPointsToCompareAll) {
+		for (size_t i = 0; i < l; i++) for (size_t j = i+1; j < l; j++) {
+			if ((*points)[i] == (*points)[j]) return false;
+		}
+		return true;
 	}
+
+	// Otherwise use an hash set to keep it linear also with thousands of points
+	std::unordered_set<Geometry::LatLon, Geometry::LatLon::Hash> uniquePoints;
+	uniquePoints.reserve(l);
+	for (size_t i = 0; i < l; i++) if (!uniquePoints.insert((*points)[i]).second) return false;
 	
 	// If we arrived here it is all OK
 	return true;
 }
 
 void Airspace::RemoveTooCloseConsecutivePoints() {
-	if (points.size() < 2) return;
-	auto prevPoint = points.begin();
-	auto it = prevPoint + 1; // second element
-	while (it != points.end()) {
-		if ((*it).IsAlmostEqual(*prevPoint)) it = points.erase(it);
-		else {
-			prevPoint = it;
-			it++;
-		}
-	}
+	if (points->size() < 2) return;
+
+	// Compact in a single pass: each point is compared with the last one kept
+	PointsChanged();
+	std::vector<Geometry::LatLon>& pts = EditPoints();
+	pts.erase(std::unique(pts.begin(), pts.end(), [](const Geometry::LatLon& kept, const Geometry::LatLon& p) { return p.IsAlmostEqual(kept); }), pts.end());
 }
 
 bool Airspace::ClosePoints() {
 	// Here we expect at least 3 points
-	if(points.size() < 3) return false;
+	if(points->size() < 3) return false;
 
 	// Make sure that the last point in the vector is equal to the first so "closing" the polygon
-	const Geometry::LatLon& first = points.front();
-	if (first != points.back()) points.push_back(first);
-
-	// Check for repeated points or equal to first
-	std::vector<Geometry::LatLon>::iterator it = std::next(points.begin()); // Start from second point
-	while(it != std::prev(points.end())) { // until the point before last one
-		if (first == (*it) || (*std::prev(it)) == (*it)) it = points.erase(it);
-		else it++;
+	PointsChanged();
+	std::vector<Geometry::LatLon>& pts = EditPoints();
+	const Geometry::LatLon first = pts.front();
+	if (first != pts.back()) pts.push_back(first);
+
+	// Remove, in a single pass, the repeated points or the ones equal to first
+	std::vector<Geometry::LatLon>::iterator last = pts.begin(); // Last point kept
+	const std::vector<Geometry::LatLon>::iterator closing = std::prev(pts.end());
+	for (std::vector<Geometry::LatLon>::iterator it = std::next(pts.begin()); it != closing; ++it) { // From second point until the point before last one
+		if (first != (*it) && (*last) != (*it)) *(++last) = *it;
 	}
+	*(++last) = first; // Keep the closing point
+	pts.erase(std::next(last), pts.end());
 
 	// For a valid closed polygon we need at least 3 points plus closing point
-	return points.size() > 3;
+	return pts.size() > 3;
 }
 
-void Airspace::AddGeometry(const Geometry* geometry) {
-	assert(geometry != nullptr);
-	geometries.push_back(geometry);
-	geometry->Discretize(points);
-}
-
-void Airspace::EvaluateAndAddArc(std::vector<Geometry::LatLon*>& arcPoints, std::vector<std::pair<const double, const double>>& centerPoints, const bool& clockwise) {
-	if (arcPoints.size() > 4) geometries.push_back(new Sector(Geometry::AveragePoints(centerPoints), *arcPoints.front(), *arcPoints.back(), clockwise));
-	else for(const Geometry::LatLon* p : arcPoints) {
-			AddPointGeometryOnly(*p);
+void Airspace::EvaluateAndAddArc(const Geometry::RadianPoints& radPoints, std::vector<size_t>& arcPoints, std::vector<std::pair<const double, const double>>& centerPoints, const bool& clockwise) {
+	if (arcPoints.size() > 4) AppendGeometry<Sector>(Geometry::AveragePoints(centerPoints), radPoints, arcPoints.front(), arcPoints.back(), clockwise);
+	else for(const size_t i : arcPoints) {
+			AddPointGeometryOnly(radPoints.Point(i));
 	}
 	arcPoints.clear();
 	centerPoints.clear();
 }
 
-void Airspace::EvaluateAndAddCircle(const std::vector<Geometry::LatLon*>& arcPoints, const std::vector<std::pair<const double, const double>>& centerPoints) {
+void Airspace::EvaluateAndAddCircle(const Geometry::RadianPoints& radPoints, const std::vector<size_t>& arcPoints, const std::vector<std::pair<const double, const double>>& centerPoints) {
 	if (arcPoints.size() > 10) {
 		
 		// Find center point
 		const Geometry::LatLon center(Geometry::AveragePoints(centerPoints));
 
 		// Calculate radius rounded in NM
-		const double radius(Geometry::RoundDistanceInNM(Geometry::AverageRadius(center, arcPoints)));
+		const double radius(Geometry::RoundDistanceInNM(Geometry::AverageRadius(center, radPoints, arcPoints)));
 
 		//TODO: Eventually check if it not a too small radius
 		//if (radius > 0.003) { // 0.003 NM = 5.556 m
 
 		// Finally add the so resulting circle
-		geometries.push_back(new Circle(center, radius));
-	} else for (const Geometry::LatLon* p : arcPoints) AddPointGeometryOnly(*p);
+		AppendGeometry<Circle>(center, radius);
+	} else for (const size_t i : arcPoints) AddPointGeometryOnly(radPoints.Point(i));
 }
 
-bool Airspace::Undiscretize() {
-	if (!geometries.empty()) return true;
-	if (points.empty()) return false;
-	assert(points.size() >= 4);
-	const size_t steps = points.size() - 2;
-	std::vector<Geometry::LatLon*> arcPoints;
+bool Airspace::Undiscretize(const double fittingToleranceMt /*= 0*/) {
+	if (!geometries->empty()) return true;
+	if (points->empty()) return false;
+	assert(points->size() >= 4);
+	if (fittingToleranceMt > 0) return FitGeometries(fittingToleranceMt);
+	const size_t steps = points->size() - 2;
+	const Geometry::RadianPoints radPoints(*points); // Convert all the points in radians only once
+	std::vector<size_t> arcPoints;
 	std::vector<std::pair<const double, const double>> centerPoints;
 	bool alreadyOnArc = false;
 	bool alwaysOnSameArc = false;
@@ -485,21 +579,21 @@ bool Airspace::Undiscretize() {
 	for (size_t a = 0, b = 1, c = 2; a < steps; a++, b++, c++) {
 		double latc = -7, lonc = -7, radius = 0;
 		bool clockwise;
-		if (Geometry::ArePointsOnArc(points.at(a), points.at(b), points.at(c), latc, lonc, radius, clockwise)) {
+		if (Geometry::ArePointsOnArc(radPoints, a, b, c, latc, lonc, radius, clockwise)) {
 			if (alreadyOnArc) { // the arc seems to continue
 				assert(prevRadius != 0);
 				const double smallDst = std::min(radius, prevRadius) / 10; // Find a small distance to compare with
 
 				// If the radius is similar to the previous and the new center is enough near to the previous consider this as the same arc
 				if (std::fabs(radius-prevRadius) < smallDst && Geometry::CalcAngularDist(latc, lonc, centerPoints.back().first, centerPoints.back().second) < smallDst) {
-					arcPoints.push_back(&points.at(c));
+					arcPoints.push_back(c);
 					centerPoints.emplace_back(latc, lonc);
 					prevRadius = radius;
 				} else { // Not on the same arc but another new one
 					assert(a > 0);
 					assert(!arcPoints.empty());
 					assert(!centerPoints.empty());
-					EvaluateAndAddArc(arcPoints, centerPoints, isClockwise);
+					EvaluateAndAddArc(radPoints, arcPoints, centerPoints, isClockwise);
 					alreadyOnArc = false;
 					prevRadius = 0;
 					alwaysOnSameArc = false;
@@ -508,9 +602,9 @@ bool Airspace::Undiscretize() {
 				assert(arcPoints.empty());
 				assert(centerPoints.empty());
 				arcPoints.reserve(3);
-				arcPoints.push_back(&points.at(a));
-				arcPoints.push_back(&points.at(b));
-				arcPoints.push_back(&points.at(c));
+				arcPoints.push_back(a);
+				arcPoints.push_back(b);
+				arcPoints.push_back(c);
 				centerPoints.emplace_back(latc, lonc);
 				isClockwise = clockwise;
 				alreadyOnArc = true;
@@ -521,48 +615,500 @@ bool Airspace::Undiscretize() {
 			if (alreadyOnArc) {
 				alreadyOnArc = false;
 				alwaysOnSameArc = false;
-				EvaluateAndAddArc(arcPoints, centerPoints, isClockwise);
+				EvaluateAndAddArc(radPoints, arcPoints, centerPoints, isClockwise);
 				prevRadius = 0;
-			} else AddPointGeometryOnly(points.at(a));
+			} else AddPointGeometryOnly(points->at(a));
 		}
 	}
 	if (alreadyOnArc) { // Add the remaining curve to geometries
 		assert(prevRadius > 0);
-		if (alwaysOnSameArc) EvaluateAndAddCircle(arcPoints, centerPoints);	// If we were always on arc then here we have a circle
-		else EvaluateAndAddArc(arcPoints, centerPoints, isClockwise);
+		if (alwaysOnSameArc) EvaluateAndAddCircle(radPoints, arcPoints, centerPoints);	// If we were always on arc then here we have a circle
+		else EvaluateAndAddArc(radPoints, arcPoints, centerPoints, isClockwise);
 	} else { // Otherwise add the remaining 2 points
-		if (!geometries.empty() && geometries.back()->GetCenterPoint() != points.at(steps)) AddPointGeometryOnly(points.at(steps));
-		if (!geometries.empty() && geometries.back()->GetCenterPoint() != points.at(steps+1)) AddPointGeometryOnly(points.at(steps+1));
+		if (!geometries->empty() && geometries->back()->GetCenterPoint() != points->at(steps)) AddPointGeometryOnly(points->at(steps));
+		if (!geometries->empty() && geometries->back()->GetCenterPoint() != points->at(steps+1)) AddPointGeometryOnly(points->at(steps+1));
 	}
 	return true;
 }
 
+// Look for the longest arc starting from start, returns the index of its last point or start if not found
+size_t Airspace::FindLongestArc(const Geometry::RadianPoints& radPoints, const size_t start, const double tolerance, Geometry::LatLon& center, double& sweep) {
+	static const size_t minArcPoints = 5; // Less points are cheaper to write as points
+	const size_t last = radPoints.Size() - 1;
+	if (start + minArcPoints - 1 > last) return start;
+	double radius;
+	size_t good = start + minArcPoints - 1;
+	if (!Geometry::FitArc(radPoints, start, good, tolerance, center, radius, sweep)) return start;
+
+	// Grow the arc doubling its length until it doesn't fit anymore
+	size_t bad = good;
+	for (size_t step = minArcPoints; good < last; step *= 2) {
+		const size_t end = std::min(last, good + step);
+		if (!Geometry::FitArc(radPoints, start, end, tolerance, center, radius, sweep) || std::fabs(sweep) >= Geometry::TWO_PI) {
+			bad = end;
+			break;
+		}
+		good = end;
+	}
+
+	// Then find the exact end with a binary search
+	while (bad > good + 1) {
+		const size_t middle = good + (bad - good) / 2;
+		if (Geometry::FitArc(radPoints, start, middle, tolerance, center, radius, sweep) && std::fabs(sweep) < Geometry::TWO_PI) good = middle;
+		else bad = middle;
+	}
+	Geometry::FitArc(radPoints, start, good, tolerance, center, radius, sweep);
+
+	// It must be really an arc and not a straight line within the tolerance
+	return radius * (1 - cos(std::min(std::fabs(sweep), Geometry::PI) / 2)) > tolerance ? good : start;
+}
+
+// Find the minimum set of arcs and points describing the polygon using least squares fitting
+bool Airspace::FitGeometries(const double toleranceMt) {
+	assert(points->front() == points->back());
+	const double tolerance = toleranceMt * Geometry::M2RAD;
+	const size_t n = points->size() - 1; // Number of vertices
+	Geometry::LatLon center;
+	double radius, sweep;
+
+	// Check if the whole polygon is a circle
+	{
+		const Geometry::RadianPoints radPoints(*points);
+		if (n > 10 && Geometry::FitArc(radPoints, 0, n, tolerance, center, radius, sweep) && std::fabs(sweep) > Geometry::PI) {
+			const double roundedRadius = Geometry::RoundDistanceInNM(radius);
+			AppendGeometry<Circle>(center, std::fabs(roundedRadius * Geometry::NM2RAD - radius) <= tolerance ? roundedRadius : radius * Geometry::RAD2NM);
+			return true;
+		}
+	}
+
+	// Start from the sharpest corner, so an arc is not broken where the polygon starts
+	size_t corner = 0;
+	{
+		double maxTurn = -1;
+		for (size_t i = 0; i < n; i++) {
+			const size_t prev = i == 0 ? n - 1 : i - 1;
+			const double crsIn = Geometry::CalcGreatCircleCourse((*points)[prev].LatRad(), (*points)[prev].LonRad(), (*points)[i].LatRad(), (*points)[i].LonRad());
+			const double crsOut = Geometry::CalcGreatCircleCourse((*points)[i].LatRad(), (*points)[i].LonRad(), (*points)[i + 1].LatRad(), (*points)[i + 1].LonRad());
+			const double turn = std::fabs(Geometry::DeltaAngle(crsOut, crsIn));
+			if (turn > maxTurn) {
+				maxTurn = turn;
+				corner = i;
+			}
+		}
+	}
+	std::vector<Geometry::LatLon> ring;
+	ring.reserve(n + 1);
+	ring.insert(ring.end(), points->begin() + corner, points->end() - 1);
+	ring.insert(ring.end(), points->begin(), points->begin() + corner);
+	ring.push_back(ring.front());
+	const Geometry::RadianPoints radPoints(ring);
+
+	// Greedily take the longest arcs, the end point of an arc can be the start of the next one
+	bool alreadyWritten = false;
+	for (size_t start = 0; start < n; ) {
+		const size_t end = FindLongestArc(radPoints, start, tolerance, center, sweep);
+		if (end > start) {
+			AppendGeometry<Sector>(center, radPoints, start, end, sweep > 0);
+			alreadyWritten = true;
+			start = end;
+			continue;
+		}
+		if (!alreadyWritten) AddPointGeometryOnly(ring[start]);
+		alreadyWritten = false;
+		start++;
+	}
+	return true;
+}
+
+// The limits on the lat/lon plane, with the right longitude beyond 180 if across the antimeridian
+static BoxXY LimitsBox(const Geometry::Limits& limits) {
+	const double right(limits.IsAcrossAntiGreenwich() ? limits.GetRightLongitudeLimit() + 360 : limits.GetRightLongitudeLimit());
+	return BoxXY(PointXY(limits.GetLeftLongitudeLimit(), limits.GetBottomLatitudeLimit()), PointXY(right, limits.GetTopLatitudeLimit()));
+}
+
+Geometry::Box Airspace::GetBoundingBox() const {
+	const std::lock_guard<std::mutex> lock(cacheMutex);
+	if (!boundingBox.IsEmpty() || points->empty()) return boundingBox;
+	boundingBox.Add(points->front());
+	double sumLon(0), sumLat(0);
+	for (size_t i = 1; i < points->size(); i++) {
+		boundingBox.Add((*points)[i]);
+		sumLon += Geometry::DeltaLonDeg((*points)[i - 1].Lon(), (*points)[i].Lon());
+		sumLat += (*points)[i].Lat();
+	}
+
+	// If it goes around a pole it contains the pole, the nearest one to its mean latitude like for the containment test
+	if (points->size() >= 4 && std::fabs(sumLon) > 180) {
+		const double pole(sumLat >= 0 ? 90 : -90);
+		boundingBox.Add(pole, pole, boundingBox.minLon, boundingBox.maxLon);
+	}
+	return boundingBox;
+}
+
 bool Airspace::IsWithinLatLonLimits(const Geometry::Limits& limits) const {
-	bool pointWhithinLimitsFound(false);
-	for(const Geometry::LatLon& pos : points) if (limits.IsPositionWithinLimits(pos)) {
-		pointWhithinLimitsFound = true;
-		break;
+	// First on the bounding box
+	const Geometry::Box box(GetBoundingBox());
+	if (box.IsOutsideLimits(limits)) return false;
+	if (box.IsWithinLimits(limits)) return true;
+
+	// Then on the points
+	for (const Geometry::LatLon& pos : *points) if (limits.IsPositionWithinLimits(pos)) return true;
+
+	// With no point within the border can still cross the limits or surround them
+	if (points->size() < 4) return false;
+	const BoxXY limitsBox(LimitsBox(limits));
+	std::vector<double> lons;
+	if (!GetContinuousLongitudes(lons)) { // Around a pole: use the containment test, which closes the border through the pole
+		const std::shared_ptr<const Geometry::EdgeTable> edges(GetEdgeTable());
+		const double top(limits.GetTopLatitudeLimit()), bottom(limits.GetBottomLatitudeLimit());
+		for (const double lon : { limits.GetLeftLongitudeLimit(), limits.GetRightLongitudeLimit() })
+			if (edges->Contains(top, lon) || edges->Contains(bottom, lon)) return true;
+		for (const Geometry::LatLon& pos : *points) // The border can enter the limits between the corners only at a vertex
+			if (limits.IsPositionWithinLimits(top, pos.Lon()) && (edges->Contains(top, pos.Lon()) || edges->Contains(bottom, pos.Lon()))) return true;
+		return false;
 	}
-	return pointWhithinLimitsFound;
+	const auto [minLon, maxLon] = std::minmax_element(lons.begin(), lons.end());
+	try {
+		for (const double shift : { -360.0, 0.0, 360.0 }) {
+			if (*maxLon + shift < limitsBox.min_corner().x() || *minLon + shift > limitsBox.max_corner().x()) continue;
+			PolygonXY polygon;
+			for (size_t i = 0; i < points->size(); i++) boost::geometry::append(polygon, PointXY(lons[i] + shift, (*points)[i].Lat()));
+			boost::geometry::correct(polygon);
+			if (boost::geometry::intersects(polygon, limitsBox)) return true;
+		}
+	} catch (...) {} // Probably an invalid polygon: consider only the points
+	return false;
 }
 
-bool Airspace::IsWithinAltLimits(const Altitude& floor, const Altitude& ceil) const {
+// Longitudes of the points continuous also across the antimeridian, false if around a pole where the border can't be put on the plane
+bool Airspace::GetContinuousLongitudes(std::vector<double>& lons) const {
+	lons.clear();
+	lons.reserve(points->size());
+	lons.push_back(points->front().Lon());
+	for (size_t i = 1; i < points->size(); i++) lons.push_back(lons.back() + Geometry::DeltaLonDeg((*points)[i - 1].Lon(), (*points)[i].Lon()));
+	return std::fabs(lons.back() - lons.front()) <= 180;
+}
+
+
+// Intersect the airspace with the limits, return false if nothing remains; if it is split the further parts are added to otherParts
+bool Airspace::ClipToLimits(const Geometry::Limits& limits, std::vector<Airspace>& otherParts, bool& clipped) {
+	clipped = false;
+	if (!limits.IsValid() || points->size() < 4) return true;
+
+	// Nothing to cut if completely inside, nothing remains if completely outside
+	const Geometry::Box bounds(GetBoundingBox());
+	if (bounds.IsWithinLimits(limits)) return true;
+	if (bounds.IsOutsideLimits(limits)) return false;
+	bool allInside(true), anyInside(false);
+	for (const Geometry::LatLon& pos : *points) {
+		const bool inside = limits.IsPositionWithinLimits(pos);
+		allInside = allInside && inside;
+		anyInside = anyInside || inside;
+	}
+	if (allInside) return true;
+
+	// Work on the lat/lon plane with continuous longitudes, also for the limits across the antimeridian
+	const BoxXY box(LimitsBox(limits));
+	const double left(box.min_corner().x()), right(box.max_corner().x());
+	std::vector<double> lons;
+	if (!GetContinuousLongitudes(lons)) return IsWithinLatLonLimits(limits); // Around a pole: can't be cut on the plane, just filter it
+	const auto [minLon, maxLon] = std::minmax_element(lons.begin(), lons.end());
+
+	// Try also with the airspace shifted by a turn, to find the parts across the antimeridian
+	std::vector<std::vector<Geometry::LatLon>> parts;
+	try {
+		for (const double shift : { -360.0, 0.0, 360.0 }) {
+			if (*maxLon + shift < left || *minLon + shift > right) continue;
+			PolygonXY polygon;
+			for (size_t i = 0; i < points->size(); i++) boost::geometry::append(polygon, PointXY(lons[i] + shift, (*points)[i].Lat()));
+			const bool counterClockwise(boost::geometry::area(polygon) < 0);
+			boost::geometry::correct(polygon);
+			MultiPolygonXY result;
+			boost::geometry::intersection(polygon, box, result);
+			for (const PolygonXY& p : result) {
+				if (p.outer().size() < 4) continue;
+				std::vector<Geometry::LatLon> part;
+				part.reserve(p.outer().size());
+				for (const PointXY& q : p.outer()) {
+					double lon(q.x());
+					if (lon > 180) lon -= 360;
+					else if (lon < -180) lon += 360;
+					part.emplace_back(q.y(), lon);
+				}
+				if (counterClockwise) std::reverse(part.begin(), part.end()); // Keep the original direction
+				parts.push_back(std::move(part));
+			}
+		}
+	} catch (...) {
+		return anyInside; // Probably an invalid polygon: just filter it
+	}
+	if (parts.empty()) return false;
+
+	// Normalize the parts like the airspaces just read, leaving out the degenerate ones
+	ClearPoints();
+	std::vector<Airspace> normalized;
+	for (std::vector<Geometry::LatLon>& part : parts) {
+		Airspace airspace(Clone());
+		airspace.points = std::make_shared<std::vector<Geometry::LatLon>>(std::move(part));
+		airspace.RemoveTooCloseConsecutivePoints();
+		if (airspace.ClosePoints() && airspace.points->size() > 3 && airspace.ArePointsValid()) normalized.push_back(std::move(airspace));
+	}
+	if (normalized.empty()) return false;
+
+	// Keep here the first part and make new airspaces for the others
+	clipped = true;
+	points = normalized.front().points;
+	for (size_t i = 1; i < normalized.size(); i++) otherParts.push_back(std::move(normalized[i]));
+	return true;
+}
+
+// Merge the touching airspaces of the group, supposed with same category and limits, into the first of each set: the merged ones remain without points
+size_t Airspace::Dissolve(const std::vector<Airspace*>& group) {
+	// Prepare the polygons on the lat/lon plane, leaving out the invalid ones and the ones across the antimeridian
+	std::vector<PolygonXY> polygons(group.size());
+	std::vector<unsigned char> counterClockwise(group.size());
+	std::vector<std::pair<BoxXY, size_t>> boxes;
+	boxes.reserve(group.size());
+	for (size_t i = 0; i < group.size(); i++) {
+		const std::vector<Geometry::LatLon>& pts = *group[i]->points;
+		if (pts.size() < 4) continue;
+		bool acrossAntimeridian(false);
+		for (size_t j = 1; j < pts.size() && !acrossAntimeridian; j++) acrossAntimeridian = std::fabs(pts[j].Lon() - pts[j - 1].Lon()) > 180;
+		if (acrossAntimeridian) continue;
+		for (const Geometry::LatLon& p : pts) boost::geometry::append(polygons[i], PointXY(p.Lon(), p.Lat()));
+		counterClockwise[i] = boost::geometry::area(polygons[i]) < 0;
+		boost::geometry::correct(polygons[i]);
+		if (group[i]->IsSelfIntersecting()) continue;
+		boxes.emplace_back(boost::geometry::return_envelope<BoxXY>(polygons[i]), i);
+	}
+	if (boxes.size() < 2) return 0;
+
+	// Find the sets of touching polygons using a spatial index on their bounding boxes, each set is represented by its first airspace
+	const boost::geometry::index::rtree<std::pair<BoxXY, size_t>, boost::geometry::index::rstar<16>> rtree(boxes.begin(), boxes.end());
+	std::vector<size_t> parent(group.size());
+	std::iota(parent.begin(), parent.end(), 0);
+	auto find = [&parent](size_t i) {
+		while (parent[i] != i) i = parent[i] = parent[parent[i]];
+		return i;
+	};
+	for (const std::pair<BoxXY, size_t>& box : boxes) {
+		for (auto it = rtree.qbegin(boost::geometry::index::intersects(box.first)); it != rtree.qend(); ++it) {
+			if (it->second <= box.second) continue;
+			size_t a(find(box.second)), b(find(it->second));
+			if (a == b || !boost::geometry::intersects(polygons[box.second], polygons[it->second])) continue;
+			if (b < a) std::swap(a, b);
+			parent[b] = a;
+		}
+	}
+	std::map<size_t, std::vector<size_t>> sets;
+	for (const std::pair<BoxXY, size_t>& box : boxes) sets[find(box.second)].push_back(box.second);
+
+	// Make the union of each set, pairwise so the intermediate results stay balanced
+	size_t merged(0);
+	for (const auto& [first, members] : sets) {
+		if (members.size() < 2) continue;
+		std::vector<MultiPolygonXY> parts;
+		parts.reserve(members.size());
+		for (const size_t m : members) {
+			parts.emplace_back();
+			parts.back().push_back(polygons[m]);
+		}
+		try {
+			while (parts.size() > 1) {
+				std::vector<MultiPolygonXY> unions;
+				unions.reserve((parts.size() + 1) / 2);
+				for (size_t k = 0; k + 1 < parts.size(); k += 2) {
+					unions.emplace_back();
+					boost::geometry::union_(parts[k], parts[k + 1], unions.back());
+				}
+				if (parts.size() % 2 == 1) unions.push_back(std::move(parts.back()));
+				parts.swap(unions);
+			}
+		} catch (...) {
+			continue; // Keep them as they are
+		}
+
+		// Only a single polygon without holes can be represented as one airspace
+		const MultiPolygonXY& result = parts.front();
+		if (result.size() != 1 || !result.front().inners().empty() || result.front().outer().size() < 4) continue;
+		Airspace& airspace = *group[first];
+		std::vector<Geometry::LatLon> pts;
+		pts.reserve(result.front().outer().size());
+		for (const PointXY& q : result.front().outer()) pts.emplace_back(q.y(), q.x());
+		if (counterClockwise[first]) std::reverse(pts.begin(), pts.end()); // Keep the original direction
+
+		// Normalize the merged border like the ones just read, if it is not valid keep the members as they are
+		Airspace candidate(airspace.Clone());
+		candidate.points = std::make_shared<std::vector<Geometry::LatLon>>(std::move(pts));
+		candidate.RemoveTooCloseConsecutivePoints();
+		if (!candidate.ClosePoints() || candidate.points->size() <= 3 || !candidate.ArePointsValid() || candidate.IsSelfIntersecting()) continue;
+		airspace.ClearPoints();
+		airspace.points = candidate.points;
+		for (const size_t m : members) {
+			if (m == first) continue;
+			group[m]->ClearPoints();
+			merged++;
+		}
+	}
+	return merged;
+}
+
+// Find the pairs of horizontally overlapping airspaces: broad phase on the bounding boxes with an R-tree then exact intersections in parallel
+// Return the number of airspaces skipped because of not valid borders
+size_t Airspace::FindOverlaps(const std::vector<const Airspace*>& airspaces, std::vector<Overlap>& overlaps) {
+	// Prepare the polygons on the plane with continuous longitudes starting within -180 and 180
+	std::vector<PolygonXY> polygons(airspaces.size());
+	std::vector<unsigned char> valid(airspaces.size()); // Not vector<bool> because written concurrently
+	Parallel::For(airspaces.size(), [&](const size_t i) {
+		const std::vector<Geometry::LatLon>& pts = *airspaces[i]->points;
+		if (pts.size() < 4) return;
+		double lon(pts.front().Lon());
+		for (size_t j = 0; j < pts.size(); j++) {
+			if (j > 0) lon += Geometry::DeltaLonDeg(pts[j - 1].Lon(), pts[j].Lon());
+			boost::geometry::append(polygons[i], PointXY(lon, pts[j].Lat()));
+		}
+		if (std::fabs(lon - pts.front().Lon()) > 180) return; // Around a pole: can't be done on the plane
+		if (boost::geometry::return_envelope<BoxXY>(polygons[i]).min_corner().x() < -180) for (PointXY& p : polygons[i].outer()) p.x(p.x() + 360);
+		boost::geometry::correct(polygons[i]);
+		valid[i] = !airspaces[i]->IsSelfIntersecting(); // Much faster than boost::geometry::is_valid() on the invalid ones
+	});
+
+	// Index the bounding boxes, the ones going beyond the antimeridian also shifted by a turn west
+	typedef std::tuple<BoxXY, size_t, double> IndexedBox; // Box, airspace index and shift
+	std::vector<std::vector<IndexedBox>> boxes(airspaces.size());
+	std::vector<IndexedBox> allBoxes;
+	allBoxes.reserve(airspaces.size());
+	size_t skipped(0);
+	for (size_t i = 0; i < airspaces.size(); i++) {
+		if (!valid[i]) {
+			skipped++;
+			continue;
+		}
+		const BoxXY box(boost::geometry::return_envelope<BoxXY>(polygons[i]));
+		boxes[i].emplace_back(box, i, 0.0);
+		if (box.max_corner().x() > 180) boxes[i].emplace_back(BoxXY(PointXY(box.min_corner().x() - 360, box.min_corner().y()), PointXY(box.max_corner().x() - 360, box.max_corner().y())), i, -360.0);
+		allBoxes.insert(allBoxes.end(), boxes[i].begin(), boxes[i].end());
+	}
+	const boost::geometry::index::rtree<IndexedBox, boost::geometry::index::rstar<16>> rtree(allBoxes.begin(), allBoxes.end());
+
+	// For each airspace intersect the following ones having the box overlapping
+	std::vector<std::vector<Overlap>> found(airspaces.size());
+	Parallel::For(airspaces.size(), [&](const size_t i) {
+		std::vector<std::pair<size_t, double>> candidates; // Airspace index and shift relative to this one
+		for (const IndexedBox& box : boxes[i])
+			for (auto it = rtree.qbegin(boost::geometry::index::intersects(std::get<0>(box))); it != rtree.qend(); ++it)
+				if (std::get<1>(*it) > i) candidates.emplace_back(std::get<1>(*it), std::get<2>(*it) - std::get<2>(box));
+		std::sort(candidates.begin(), candidates.end());
+		candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+		for (const std::pair<size_t, double>& candidate : candidates) {
+			PolygonXY other(polygons[candidate.first]);
+			if (candidate.second != 0) for (PointXY& p : other.outer()) p.x(p.x() + candidate.second);
+			MultiPolygonXY intersection;
+			try {
+				boost::geometry::intersection(polygons[i], other, intersection);
+			} catch (...) {
+				continue;
+			}
+
+			// Area of the intersection on the WGS84 spheroid
+			double areaKm2(0);
+			for (const PolygonXY& p : intersection) {
+				GeographicPolygon geoPolygon;
+				for (const PointXY& q : p.outer()) boost::geometry::append(geoPolygon.outer(), boost::make_tuple(q.x(), q.y()));
+				geoPolygon.inners().resize(p.inners().size());
+				for (size_t r = 0; r < p.inners().size(); r++) for (const PointXY& q : p.inners()[r]) boost::geometry::append(geoPolygon.inners()[r], boost::make_tuple(q.x(), q.y()));
+				areaKm2 += std::fabs(boost::geometry::area(geoPolygon, wgs84));
+			}
+			if (areaKm2 > 1e-6) found[i].push_back({ i, candidate.first, areaKm2 }); // Ignore the ones just touching
+		}
+	});
+	for (std::vector<Overlap>& f : found) overlaps.insert(overlaps.end(), f.begin(), f.end());
+	return skipped;
+}
+
+std::shared_ptr<const Geometry::EdgeTable> Airspace::GetEdgeTable() const {
+	const std::lock_guard<std::mutex> lock(cacheMutex);
+	if (!edgeTable) edgeTable = std::make_shared<const Geometry::EdgeTable>(*points);
+	return edgeTable;
+}
+
+// Point in polygon test, also for airspaces across the antimeridian or around a pole
+bool Airspace::Contains(const double lat, const double lon) const {
+	return GetEdgeTable()->Contains(lat, lon);
+}
+
+void Airspace::Contains(const std::vector<Geometry::LatLon>& positions, std::vector<bool>& inside) const {
+	const std::shared_ptr<const Geometry::EdgeTable> edges(GetEdgeTable());
+	inside.resize(positions.size());
+	for (size_t i = 0; i < positions.size(); i++) inside[i] = edges->Contains(positions[i].Lat(), positions[i].Lon());
+}
+
+bool Airspace::IsWithinAltLimits(const Altitude& base, const Altitude& top, const Altitude& floor, const Altitude& ceil) {
 	if (top < ceil && top > floor) return true;
 	if (base > floor && base < ceil) return true;
 	return false;
 }
 
-void Airspace::CalculateSurface(double& area, double& perimeter) const {
-	// Create geographic polygon
-	boost::geometry::model::polygon<boost::geometry::model::point<double, 2, boost::geometry::cs::geographic<boost::geometry::degree> > > polygon;
-	for (const Geometry::LatLon& point : points) boost::geometry::append(polygon, boost::make_tuple(point.Lon(), point.Lat()));
+std::string Airspace::GetSourceLocation() const {
+	if (!sourceFile) return "unknown file";
+	return sourceLine > 0 ? std::format("{} at line {}", *sourceFile, sourceLine) : *sourceFile;
+}
 
-	// Geographic strategy with WGS84 spheroid (spheroid sizes in Km)
-	static const boost::geometry::strategy::area::geographic<> wgs84(boost::geometry::srs::spheroid<double>(6378.137, 6356.7523142451793));
+bool Airspace::IsSelfIntersecting() const {
+	return points->size() > 3 && points->front() == points->back() && Geometry::IsSelfIntersecting(*points);
+}
 
-	// Geographic strategy with Vincenty algorithm
-	//static const boost::geometry::strategy::area::geographic<boost::geometry::model::point<double, 2, boost::geometry::cs::geographic<boost::geometry::degree >>, boost::geometry::formula::vincenty_inverse> vincenty;
+bool Airspace::RemoveSpikes() {
+	if (points->size() <= 3 || points->front() != points->back() || !Geometry::RemoveSpikes(EditPoints())) return false;
+	ClearGeometries(); // The geometries do not correspond anymore to the points
+	return true;
+}
+
+bool Airspace::Simplify(const double toleranceMt, const size_t maxPoints /*= 0*/) {
+	if (points->size() <= 4 || points->front() != points->back() || !Geometry::Simplify(EditPoints(), toleranceMt, maxPoints)) return false;
+	ClearGeometries(); // The original geometries do not correspond anymore to the points
+	return true;
+}
+
+void Airspace::CalculateSurface(double& area, double& perimeter, const bool onSphere /*= false*/) const {
+	// Use the values already calculated, if in the same way
+	{
+		const std::lock_guard<std::mutex> lock(cacheMutex);
+		if (areaKm2 >= 0 && surfaceOnSphere == onSphere) {
+			area = areaKm2;
+			perimeter = perimeterKm;
+			return;
+		}
+	}
 
-	area = std::fabs(boost::geometry::area(polygon, wgs84)); // [Km2]
-	perimeter = boost::geometry::perimeter(polygon) / 1000; // [Km]
+	if (onSphere) CalculateSurfaceOnSphere(area, perimeter);
+	else {
+		// Create geographic polygon
+		GeographicPolygon polygon;
+		for (const Geometry::LatLon& point : *points) boost::geometry::append(polygon, boost::make_tuple(point.Lon(), point.Lat()));
+
+		// Geographic strategy with Vincenty algorithm
+		//static const boost::geometry::strategy::area::geographic<boost::geometry::model::point<double, 2, boost::geometry::cs::geographic<boost::geometry::degree >>, boost::geometry::formula::vincenty_inverse> vincenty;
+
+		area = std::fabs(boost::geometry::area(polygon, wgs84)); // [Km2]
+		perimeter = boost::geometry::perimeter(polygon) / 1000; // [Km]
+	}
+
+	// Remember them
+	const std::lock_guard<std::mutex> lock(cacheMutex);
+	areaKm2 = area;
+	perimeterKm = perimeter;
+	surfaceOnSphere = onSphere;
+}
+
+// Faster approximation with the spherical excess of each edge and great circle distances
+void Airspace::CalculateSurfaceOnSphere(double& area, double& perimeter) const {
+	const Geometry::RadianPoints radPoints(*points);
+	double excess(0), length(0);
+	for (size_t i = 1; i < radPoints.Size(); i++) {
+		excess += Geometry::AnglePi2Pi(radPoints.LonRad(i) - radPoints.LonRad(i - 1)) * (2 + radPoints.Z(i - 1) + radPoints.Z(i)); // Z is the sine of latitude
+		length += Geometry::CalcAngularDist(radPoints, i - 1, i);
+	}
+	area = std::fabs(excess) / 2 * Geometry::EARTH_RADIUS_KM * Geometry::EARTH_RADIUS_KM; // [Km2]
+	perimeter = length * Geometry::EARTH_RADIUS_KM; // [Km]
 }
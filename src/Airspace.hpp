@@ -13,8 +13,12 @@
 #pragma once
 #include <string>
 #include <vector>
+#include <memory>
+#include <mutex>
 #include "Geometry.hpp"
 #include "Altitude.hpp"
+#include "StringPool.hpp"
+#include "Arena.hpp"
 
 class Airspace {
 public:
@@ -72,13 +76,12 @@ public:
 		UNDEFINED	// also the last one
 	} Type;
 
-	Airspace() : type(UNDEFINED), airspaceClass(UNDEFINED), transponderCode(-1) {}
+	Airspace() : geometries(NO_GEOMETRIES), points(NO_POINTS), type(UNDEFINED), airspaceClass(UNDEFINED), transponderCode(-1), sourceLine(-1), areaKm2(-1), perimeterKm(-1), surfaceOnSphere(false) {}
 	Airspace(Type category);
-	Airspace(const Airspace& orig);
-	Airspace(Airspace&& orig);
-	~Airspace();
-
-	Airspace& operator=(const Airspace& other);
+	Airspace(Airspace&& orig) noexcept;
+	Airspace& operator=(const Airspace& other) = delete; // Airspaces are only moved, use Clone() to duplicate one
+	Airspace& operator=(Airspace&& other) noexcept;
+	inline Airspace Clone() const { return Airspace(*this); } // The copy shares points and geometries until one of the two changes them
 	bool operator==(const Airspace& other) const;
 	inline static const std::string& CategoryName(const Type& category) { return CATEGORY_NAMES[category]; }
 	inline static const std::string& LongCategoryName(const Type& category) { return LONG_CATEGORY_NAMES[category]; }
@@ -89,7 +92,8 @@ public:
 	bool NameStartsWithIdent(const std::string& ident);
 	inline void SetTopAltitude(const Altitude& alt) { top = alt; }
 	inline void SetBaseAltitude(const Altitude& alt) { base = alt; }
-	inline void SetName(const std::string& airspaceName) { name = airspaceName; }
+	inline void ApplyQNH(const double QNHhPa) { top.ApplyQNH(QNHhPa); base.ApplyQNH(QNHhPa); } // Recalculate the altitudes of the flight levels
+	inline void SetName(const std::string& airspaceName) { name = InternedString(airspaceName); }
 	bool SetTransponderCode(const std::string& code);
 	void AddRadioFrequency(const int frequencyHz, const std::string& description);
 	void Clear(); // Clear name, type, points and geometries
@@ -97,53 +101,102 @@ public:
 	void ClearGeometries(); // Clear geometries only
 	bool AddPoint(const Geometry::LatLon& point);
 	bool AddPointLatLonOnly(const double& lat, const double& lon);
-	void AddGeometry(const Geometry* geometry);
+	template<typename G, typename... Args>
+	inline void AddGeometry(const double resolution, Args&&... args) { AppendGeometry<G>(std::forward<Args>(args)...).Discretize(EditPoints(), resolution); } // Build the geometry and add its points, at most resolution [rad] apart
+	template<typename G, typename... Args>
+	inline void AddGeometryOnly(Args&&... args) { AppendGeometry<G>(std::forward<Args>(args)...); } // Build the geometry without adding its points yet
+	void DiscretizeGeometries(const size_t first, const double resolution); // Add the points of the geometries from first on, added with AddGeometryOnly()
+	inline void SetArena(const std::shared_ptr<Arena>& datasetArena) { arena = datasetArena; } // Where to allocate the geometries while reading, if not set on the heap
 	bool ClosePoints();
 	bool ArePointsValid() const;
 	void RemoveTooCloseConsecutivePoints();
-	bool Undiscretize();
-	bool IsWithinLatLonLimits(const Geometry::Limits& limits) const;
-	bool IsWithinAltLimits(const Altitude& floor, const Altitude& ceil) const;
-	inline void CutPointsFrom(Airspace& orig) { points = std::move(orig.points); }
+	bool Undiscretize(const double fittingToleranceMt = 0);
+	Geometry::Box GetBoundingBox() const; // Calculated at first use and forgotten when the points change, up to the pole if around it
+	bool IsWithinLatLonLimits(const Geometry::Limits& limits) const; // True if any part of the airspace is within the limits
+	bool ClipToLimits(const Geometry::Limits& limits, std::vector<Airspace>& otherParts, bool& clipped);
+	inline bool IsWithinAltLimits(const Altitude& floor, const Altitude& ceil) const { return IsWithinAltLimits(base, top, floor, ceil); }
+	static bool IsWithinAltLimits(const Altitude& base, const Altitude& top, const Altitude& floor, const Altitude& ceil);
+	bool Contains(const double lat, const double lon) const;
+	void Contains(const std::vector<Geometry::LatLon>& positions, std::vector<bool>& inside) const;
+	static size_t Dissolve(const std::vector<Airspace*>& group);
+	struct Overlap {
+		size_t first, second; // Indexes of the two overlapping airspaces
+		double areaKm2; // Area of their intersection [Km2]
+	};
+	static size_t FindOverlaps(const std::vector<const Airspace*>& airspaces, std::vector<Overlap>& overlaps);
+	inline void CutPointsFrom(Airspace& orig) { points = std::move(orig.points); orig.points = NO_POINTS; PointsChanged(); orig.PointsChanged(); }
 	inline const Type& GetType() const { return type; }
 	inline const Type& GetClass() const { return airspaceClass; }
 	inline const std::string& GetCategoryName() const { return CategoryName(type); }
 	inline const std::string& GetLongCategoryName() const { return LongCategoryName(type); }
 	inline const Altitude& GetTopAltitude() const { return top; }
 	inline const Altitude& GetBaseAltitude() const { return base; }
-	inline const std::string& GetName() const { return name; }
-	inline size_t GetNumberOfGeometries() const { return geometries.size(); }
-	inline const Geometry* GetGeometryAt(size_t i) { return i < geometries.size() ? geometries.at(i) : nullptr; }
-	inline const std::vector<Geometry::LatLon>& GetPoints() const { return points; }
-	inline const Geometry::LatLon& GetFirstPoint() const { return points.front(); }
-	inline const Geometry::LatLon& GetLastPoint() const { return points.back(); }
-	inline size_t GetNumberOfPoints() const { return points.size(); }
-	inline const Geometry::LatLon& GetPointAt(size_t pos) const { return points.at(pos); }
+	inline const std::string& GetName() const { return name.Get(); }
+	inline const InternedString& GetInternedName() const { return name; } // To compare names just by address
+	inline size_t GetNumberOfGeometries() const { return geometries->size(); }
+	inline const Geometry* GetGeometryAt(size_t i) { return i < geometries->size() ? geometries->at(i).get() : nullptr; }
+	inline const std::vector<Geometry::LatLon>& GetPoints() const { return *points; }
+	inline const Geometry::LatLon& GetFirstPoint() const { return points->front(); }
+	inline const Geometry::LatLon& GetLastPoint() const { return points->back(); }
+	inline size_t GetNumberOfPoints() const { return points->size(); }
+	inline const Geometry::LatLon& GetPointAt(size_t pos) const { return points->at(pos); }
 	inline bool IsGNDbased() const { return base.IsGND(); }
 	inline bool IsMSLbased() const { return base.IsMSL(); }
 	inline bool IsAGLtopped() const { return top.IsAGL(); }
 	inline bool IsAMSLtopped() const { return top.IsAMSL(); }
 	inline bool IsVisibleByDefault() const { return CategoryVisibleByDefault(type); }
 	inline size_t GetNumberOfRadioFrequencies() const { return radioFrequencies.size(); }
-	inline const std::pair<int, std::string>& GetRadioFrequencyAt(size_t pos) const { return radioFrequencies.at(pos); }
+	inline const std::pair<int, InternedString>& GetRadioFrequencyAt(size_t pos) const { return radioFrequencies.at(pos); }
 	std::string GetTransponderCode() const;
 	inline bool HasTransponderCode() const { return transponderCode >= 0; }
-	void CalculateSurface(double& areaKm2, double& perimeterKm) const;
+	void CalculateSurface(double& areaKm2, double& perimeterKm, const bool onSphere = false) const;
+	inline void SetSource(const std::shared_ptr<const std::string>& file, const int line = -1) { sourceFile = file; sourceLine = line; }
+	std::string GetSourceLocation() const;
+	bool IsSelfIntersecting() const;
+	bool RemoveSpikes();
+	bool Simplify(const double toleranceMt, const size_t maxPoints = 0);
 
 private:
+	Airspace(const Airspace& orig); // Used only by Clone()
+	std::vector<Geometry::LatLon>& EditPoints();
+	std::vector<std::shared_ptr<const Geometry>>& EditGeometries();
+	template<typename G, typename... Args>
+	const G& AppendGeometry(Args&&... args) {
+		const std::shared_ptr<const G> geometry(arena != nullptr ?
+			std::allocate_shared<G>(Arena::Allocator<G>(arena), std::forward<Args>(args)...) :
+			std::make_shared<G>(std::forward<Args>(args)...));
+		EditGeometries().push_back(geometry);
+		return *geometry;
+	}
 	bool AddPointGeometryOnly(const Geometry::LatLon& point);
-	void EvaluateAndAddArc(std::vector<Geometry::LatLon*>& arcPoints, std::vector<std::pair<const double, const double>>& centerPoints, const bool& clockwise);
-	void EvaluateAndAddCircle(const std::vector<Geometry::LatLon*>& arcPoints, const std::vector<std::pair<const double, const double>>& centerPoints);
+	void EvaluateAndAddArc(const Geometry::RadianPoints& radPoints, std::vector<size_t>& arcPoints, std::vector<std::pair<const double, const double>>& centerPoints, const bool& clockwise);
+	void EvaluateAndAddCircle(const Geometry::RadianPoints& radPoints, const std::vector<size_t>& arcPoints, const std::vector<std::pair<const double, const double>>& centerPoints);
+	bool FitGeometries(const double toleranceMt);
+	inline void PointsChanged() { edgeTable.reset(); areaKm2 = -1; boundingBox = Geometry::Box(); } // Forget the values calculated from the points
+	bool GetContinuousLongitudes(std::vector<double>& lons) const;
+	std::shared_ptr<const Geometry::EdgeTable> GetEdgeTable() const;
+	void CalculateSurfaceOnSphere(double& area, double& perimeter) const;
+	static size_t FindLongestArc(const Geometry::RadianPoints& radPoints, const size_t start, const double tolerance, Geometry::LatLon& center, double& sweep);
 
 	static const std::string CATEGORY_NAMES[];
 	static const std::string LONG_CATEGORY_NAMES[];
 	static const bool CATEGORY_VISIBILITY[];
+	static const std::shared_ptr<std::vector<std::shared_ptr<const Geometry>>> NO_GEOMETRIES;
+	static const std::shared_ptr<std::vector<Geometry::LatLon>> NO_POINTS;
 	Altitude top, base;
-	std::vector<const Geometry*> geometries;
-	std::vector<Geometry::LatLon> points;
+	std::shared_ptr<std::vector<std::shared_ptr<const Geometry>>> geometries; // Shared with the clones, copied before being changed
+	std::shared_ptr<std::vector<Geometry::LatLon>> points; // Shared with the clones, copied before being changed
+	std::shared_ptr<Arena> arena; // Memory of the dataset being read where the geometries are allocated, null for the heap
 	Type type;
 	Type airspaceClass; // This is to remember the class of a TMA or CTR where possible
-	std::string name;
-	std::vector<std::pair<int,std::string>> radioFrequencies; // Radio frequencies list values expressed in [Hz] and name/description
+	InternedString name;
+	std::vector<std::pair<int,InternedString>> radioFrequencies; // Radio frequencies list values expressed in [Hz] and name/description
 	short transponderCode; // Transponder code mandated for this airspace 12 bits used (OCT:7777 = DEC:4095 = BIN:1111111111)
+	std::shared_ptr<const std::string> sourceFile; // Name of the file where it was read, shared by all the airspaces of the same file
+	int sourceLine; // Line in the source file where its definition starts, if known
+	mutable std::mutex cacheMutex; // Protects the values below, calculated on demand and forgotten when the points change
+	mutable std::shared_ptr<const Geometry::EdgeTable> edgeTable; // Built at the first containment test
+	mutable double areaKm2, perimeterKm; // Negative if not yet calculated
+	mutable bool surfaceOnSphere; // If area and perimeter were calculated with the spherical approximation
+	mutable Geometry::Box boundingBox; // Empty if not yet calculated
 };
@@ -13,24 +13,28 @@
 #include "AirspaceConverter.hpp"
 #include "Airspace.hpp"
 #include "Waypoint.hpp"
-#include "RasterMap.hpp"
 #include "KML.hpp"
 #include "OpenAir.hpp"
 #include "SeeYou.hpp"
 #include "OpenAIP.hpp"
 #include "Polish.hpp"
 #include "CSV.hpp"
+#include "Parallel.hpp"
 #include <iostream>
 #include <locale>
 #include <sstream>
+#include <fstream>
 #include <chrono>
 #include <iomanip>
 #include <cmath>
 #include <map>
 #include <tuple>
+#include <utility>
 #include <filesystem>
 #include <format>
 #include <boost/algorithm/string/predicate.hpp>
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/tokenizer.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
 #include <boost/beast/version.hpp>
@@ -102,9 +106,6 @@ const std::vector<std::string> AirspaceConverter::disclaimer = {
 	"Error reports, complaints and suggestions please email to: info@alus.it",
 };
 
-std::vector<RasterMap*> AirspaceConverter::terrainMaps;
-double AirspaceConverter::defaultTerrainAltitudeMt = 20;
-
 const std::string AirspaceConverter::cGPSmapperCommand = Detect_cGPSmapperPath();
 
 
@@ -114,7 +115,6 @@ AirspaceConverter::AirspaceConverter() :
 }
 
 AirspaceConverter::~AirspaceConverter() {
-	ClearTerrainMaps();
 	UnloadWaypoints();
 }
 
@@ -242,11 +242,11 @@ bool AirspaceConverter::PutTypeExtension(const OutputType type, std::string& fil
 void AirspaceConverter::LoadAirspaces(const OutputType suggestedTypeForOutputFilename /* = OutputType::KMZ_Format */) {
 	if (airspaceFiles.empty()) return;
 	conversionDone = false;
-	OpenAir openAir(airspaces);
-	OpenAIP openAIP(airspaces, waypoints);
-	KML kml(airspaces, waypoints);
+	OpenAir openAir(airspaces, context);
+	OpenAIP openAIP(airspaces, waypoints, context);
+	KML kml(airspaces, waypoints, context);
 	kml.ProcessLineStrings(processLineStrings);
-	const size_t initialAirspacesNumber = airspaces.size(); // Airspaces originally already loaded
+	const size_t initialAirspacesNumber = airspaces.Size(); // Airspaces originally already loaded
 	for (const std::string& inputFile : airspaceFiles) {
 		const std::string ext(std::filesystem::path(inputFile).extension().string());
 		if(boost::iequals(ext, ".openair") || boost::iequals(ext, ".txt")) openAir.Read(inputFile);
@@ -259,7 +259,7 @@ void AirspaceConverter::LoadAirspaces(const OutputType suggestedTypeForOutputFil
 		}
 
 		// Set (suggest) the output file name if still not defined by the user
-		if (airspaces.size() > initialAirspacesNumber && outputFile.empty()) switch (suggestedTypeForOutputFilename) {
+		if (airspaces.Size() > initialAirspacesNumber && outputFile.empty()) switch (suggestedTypeForOutputFilename) {
 			default:
 				assert(false);
 				/* no break */
@@ -276,13 +276,13 @@ void AirspaceConverter::LoadAirspaces(const OutputType suggestedTypeForOutputFil
 				outputFile = std::filesystem::path(inputFile).replace_extension(".img").string();
 		}
 	}
-	LogMessage(std::format("Read {} airspace definition(s) from {} file(s).", airspaces.size() - initialAirspacesNumber, airspaceFiles.size()));
+	LogMessage(std::format("Read {} airspace definition(s) from {} file(s).", airspaces.Size() - initialAirspacesNumber, airspaceFiles.size()));
 	airspaceFiles.clear();
 }
 
 void AirspaceConverter::UnloadAirspaces() {
 	conversionDone = false;
-	airspaces.clear();
+	airspaces.Clear();
 	outputFile.clear();
 }
 
@@ -304,10 +304,10 @@ void AirspaceConverter::LoadWaypoints() {
 	if (waypointFiles.empty()) return;
 	conversionDone = false;
 	int counter = 0;
-	const size_t wptCounter = waypoints.size();
-	SeeYou cu(waypoints);
-	CSV csv(waypoints);
-	OpenAIP openAIP(airspaces, waypoints);
+	const size_t wptCounter = waypoints.Size();
+	SeeYou cu(waypoints, context);
+	CSV csv(waypoints, context);
+	OpenAIP openAIP(airspaces, waypoints, context);
 	for (const std::string& inputFile : waypointFiles) {
 		bool readOk(false);
 		const std::string ext(std::filesystem::path(inputFile).extension().string());
@@ -322,76 +322,38 @@ void AirspaceConverter::LoadWaypoints() {
 		if (readOk && outputFile.empty()) outputFile = std::filesystem::path(inputFile).replace_extension(".kmz").string(); // Default output as KMZ
 	}
 	waypointFiles.clear();
-	if (counter > 0) LogMessage(std::format("Read successfully {} waypoint(s) from {} file(s).", waypoints.size() - wptCounter, counter));
+	if (counter > 0) LogMessage(std::format("Read successfully {} waypoint(s) from {} file(s).", waypoints.Size() - wptCounter, counter));
 }
 
 void AirspaceConverter::UnloadWaypoints() {
 	conversionDone = false;
-	for (const std::pair<const int, Waypoint*>& wpt : waypoints) delete wpt.second;
-	waypoints.clear();
-	if (airspaces.empty()) outputFile.clear();
+	waypoints.Clear();
+	if (airspaces.Empty()) outputFile.clear();
 }
 
 void AirspaceConverter::SetQNH(const double newQNHhPa) {
-	Altitude::SetQNH(newQNHhPa);
+	if (newQNHhPa == context.QNH) return;
+	context.QNH = newQNHhPa;
+
+	// The flight levels are kept as such, so only their altitudes have to be recalculated without reading again the input files
+	if (airspaces.Empty()) return;
+	conversionDone = false;
+	airspaces.ParallelForEach([newQNHhPa](const size_t, Airspace& airspace) { airspace.ApplyQNH(newQNHhPa); });
 }
 
 double AirspaceConverter::GetQNH() const {
-	return Altitude::GetQNH();
+	return context.QNH;
 }
 
 bool AirspaceConverter::AddTerrainMap(const std::string& filename) {
-	RasterMap* pTerrainMap = new RasterMap();
-	if (pTerrainMap == nullptr) return false;
-	if (!pTerrainMap->Open(filename)) {
-		delete pTerrainMap;
-		return false;
-	}
-	terrainMaps.push_back(pTerrainMap);
+	std::shared_ptr<TerrainMaps> maps(std::make_shared<TerrainMaps>(*context.terrainMaps)); // The current maps may be shared with other converters
+	if (!maps->Add(filename)) return false;
+	context.terrainMaps = maps;
 	return true;
 }
 
 void AirspaceConverter::ClearTerrainMaps() {
-	for (RasterMap* pTerreinMap : terrainMaps) if (pTerreinMap != nullptr) delete pTerreinMap;
-	terrainMaps.clear();
-}
-
-bool AirspaceConverter::GetTerrainAltitudeMt(const double& lat, const double& lon, double& alt) {
-	if (terrainMaps.empty()) return false; // no maps no party...
-	const RasterMap* bestMap = terrainMaps.front();
-	if (terrainMaps.size() > 1)
-	{
-		std::multimap<double, const RasterMap*> results; // preselected maps, minStepSize (kind of resolution) used as key
-		double minStepSize = 8000; // 8000 it's just a quite big number which I like
-		for (const RasterMap* pTerreinMap : terrainMaps) {
-			if (pTerreinMap->PointIsInTerrainRange(lat, lon)) { // of course we want only maps covering our desired point!
-				double stepSize = pTerreinMap->GetStepSize();
-				if (stepSize < minStepSize) minStepSize = stepSize; // remember the best resolution
-				results.insert(std::pair<double, const RasterMap*>(stepSize, pTerreinMap)); // maps indexed on resolution
-			}
-		}
-		if (results.empty()) return false; // no results, the party is over ...
-		if (results.size() == 1) bestMap = results.begin()->second; // only one, so that's easy
-		else {
-			double minLatDiff = 90; // to find a latitude difference more than 90 degrees should be quite challenging...
-			const auto filtered = results.equal_range(minStepSize); // so now we have maps indexed on resolution and we even know the best resolution ...
-			for (auto it = filtered.first; it != filtered.second; ++it) { // look for the map with our point at higer absolute latitudes (samples more dense on earth surface)
-				double latDiff = lat >= 0 ? it->second->GetTop() - lat : lat - it->second->GetBottom();
-				assert(latDiff >= 0);
-				if (latDiff < minLatDiff) { // look for the minimum latitude difference with the proper N or S edge of the map
-					minLatDiff = latDiff;
-					bestMap = it->second;
-				}
-			}
-		}
-		assert(bestMap->PointIsInTerrainRange(lat, lon));
-	}
-	short altMt;
-	if (bestMap->GetTerrainHeight(lat, lon, altMt)) {
-		alt = altMt;
-		return true;
-	}
-	return false;
+	context.terrainMaps = std::make_shared<const TerrainMaps>();
 }
 
 bool AirspaceConverter::Convert() {
@@ -400,20 +362,20 @@ bool AirspaceConverter::Convert() {
 	switch (GetOutputType()) {
 	case OutputType::KMZ_Format:
 		{
-			KML writer(airspaces, waypoints);
+			KML writer(airspaces, waypoints, context);
 			if (writer.Write(outputFile)) {
 				conversionDone = true;
-				if(terrainMaps.empty()) LogWarning("no raster terrain map loaded, used default terrain height for all applicable AGL points.");
+				if(context.terrainMaps->Empty()) LogWarning("no raster terrain map loaded, used default terrain height for all applicable AGL points.");
 				else if(!writer.WereAllAGLaltitudesCovered()) LogWarning("not all AGL altitudes were under coverage of the loaded terrain map(s).");
 			}
 		}
 		break;
 	case OutputType::OpenAir_Format:
 
-		conversionDone = OpenAir(airspaces).Write(outputFile);
+		conversionDone = OpenAir(airspaces, context).Write(outputFile);
 		break;
 	case OutputType::SeeYou_Format:
-		conversionDone = SeeYou(waypoints).Write(outputFile);
+		conversionDone = SeeYou(waypoints, context).Write(outputFile);
 		break;
 	case OutputType::Polish_Format:
 		conversionDone = Polish().Write(outputFile, airspaces);
@@ -430,7 +392,7 @@ bool AirspaceConverter::Convert() {
 		}
 		break;
 	case OutputType::CSV_Format:
-		conversionDone = CSV(waypoints).Write(outputFile);
+		conversionDone = CSV(waypoints, context).Write(outputFile);
 		break;
 	default:
 		LogError("Output file extension/type unknown.");
@@ -440,7 +402,7 @@ bool AirspaceConverter::Convert() {
 	return conversionDone;
 }
 
-bool AirspaceConverter::ParseAltitude(const std::string& text, const bool isTop, Airspace& airspace) {
+bool AirspaceConverter::ParseAltitude(const std::string& text, const bool isTop, Airspace& airspace, const double QNHhPa) {
 	if (text.empty()) return false;
 	const std::string::size_type l = text.length();
 	double value = 0;
@@ -520,8 +482,8 @@ bool AirspaceConverter::ParseAltitude(const std::string& text, const bool isTop,
 	}
 	if (!valueFound) return false;
 	Altitude alt;
-	if (isUnlimited) alt.SetUnlimited();
-	else if (isFL) alt.SetFlightLevel((int)value);
+	if (isUnlimited) alt.SetUnlimited(true, QNHhPa);
+	else if (isFL) alt.SetFlightLevel((int)value, QNHhPa);
 	else if (isInFeet) alt.SetAltFt((int)value, isAMSL);
 	else alt.SetAltMt(value, isAMSL);
 	isTop ? airspace.SetTopAltitude(alt) : airspace.SetBaseAltitude(alt);
@@ -593,7 +555,7 @@ bool AirspaceConverter::CheckNDBfrequency(const double& frequencykHz, int& frequ
 	return true;
 }
 
-bool AirspaceConverter::FilterOnLatLonLimits(const double& topLat, const double& bottomLat, const double& leftLon, const double& rightLon) {
+bool AirspaceConverter::FilterOnLatLonLimits(const double& topLat, const double& bottomLat, const double& leftLon, const double& rightLon, const bool clip /*= false*/) {
 	// Check if it is necessary to filter
 	if (topLat == 90 && bottomLat == -90 && leftLon == -180 && rightLon == 180) return true;
 
@@ -604,27 +566,52 @@ bool AirspaceConverter::FilterOnLatLonLimits(const double& topLat, const double&
 	if (!limits.IsValid()) return false;
 
 	// Filter airspace
-	if (!airspaces.empty()) {
-		const unsigned long origAirspaces(GetNumOfAirspaces());
-		for (std::multimap<int, Airspace>::iterator it = airspaces.begin(); it != airspaces.end(); ) {
-			if ((*it).second.IsWithinLatLonLimits(limits)) ++it;
-			else it = airspaces.erase(it);
+	if (!airspaces.Empty() && !clip) {
+		// Look at the points only of the ones found by the spatial index with the bounding box not all inside the limits
+		std::vector<size_t> touching;
+		airspaces.Query(limits, touching);
+		const std::vector<AirspaceStore::Hot>& hot(airspaces.GetHotFields());
+		std::vector<unsigned char> outside(airspaces.Size(), true);
+		for (const size_t i : touching) outside[i] = false;
+		std::as_const(airspaces).ParallelForEach([&](const size_t i, const Airspace& airspace) {
+			if (outside[i] || hot[i].IsWithinLatLonLimits(limits)) return;
+			outside[i] = !airspace.IsWithinLatLonLimits(limits);
+		});
+		const size_t excluded(airspaces.Remove(outside));
+		LogMessage(std::format("Filtering airspaces on position... excluded: {}, remaining: {}", excluded, GetNumOfAirspaces()));
+	}
+
+	// Or clip them on the limits
+	if (!airspaces.Empty() && clip) {
+		// The ones not found by the spatial index are all outside
+		std::vector<size_t> touching;
+		airspaces.Query(limits, touching);
+		std::vector<unsigned char> excluded(airspaces.Size(), true), clipped(airspaces.Size());
+		for (const size_t i : touching) excluded[i] = false;
+		std::vector<std::vector<Airspace>> otherParts(airspaces.Size());
+		airspaces.ParallelForEach([&](const size_t i, Airspace& airspace) {
+			if (excluded[i]) return;
+			bool isClipped(false);
+			excluded[i] = !airspace.ClipToLimits(limits, otherParts[i], isClipped);
+			clipped[i] = isClipped;
+		});
+		const size_t numExcluded(airspaces.Remove(excluded));
+		unsigned long numClipped(0);
+		for (size_t i = 0; i < otherParts.size(); i++) {
+			if (excluded[i]) continue;
+			if (clipped[i]) numClipped++;
+			for (Airspace& part : otherParts[i]) airspaces.Insert(std::move(part));
 		}
-		LogMessage(std::format("Filtering airspaces on position... excluded: {}, remaining: {}", origAirspaces - GetNumOfAirspaces(), GetNumOfAirspaces()));
+		LogMessage(std::format("Clipping airspaces on position... excluded: {}, clipped: {}, remaining: {}", numExcluded, numClipped, GetNumOfAirspaces()));
 	}
 
 	// Filter waypoints
-	if (!waypoints.empty()) {
-		const unsigned long origWaypoints(GetNumOfWaypoints());
-		for (std::multimap<int, Waypoint*>::iterator it = waypoints.begin(); it != waypoints.end(); ) {
-			Waypoint* w = (*it).second;
-			if (limits.IsPositionWithinLimits(w->GetPosition())) ++it;
-			else {
-				it = waypoints.erase(it);
-				delete(w);
-			}
-		}
-		LogMessage(std::format("Filtering waypoints on position... excluded: {}, remaining: {}", origWaypoints - GetNumOfWaypoints(), GetNumOfWaypoints()));
+	if (!waypoints.Empty()) {
+		const std::vector<Geometry::LatLon>& positions(waypoints.GetPositions());
+		std::vector<unsigned char> outside(positions.size());
+		Parallel::For(positions.size(), [&](const size_t i) { outside[i] = !limits.IsPositionWithinLimits(positions[i]); });
+		const size_t excluded(waypoints.Remove(outside));
+		LogMessage(std::format("Filtering waypoints on position... excluded: {}, remaining: {}", excluded, GetNumOfWaypoints()));
 	}
 	return true;
 }
@@ -637,68 +624,263 @@ bool AirspaceConverter::FilterOnAltitudeLimits(const Altitude& floor, const Alti
 	if (ceiling < floor) return false;
 
 	// Filter airspace
-	if (!airspaces.empty()) {
-		const unsigned long origAirspaces(GetNumOfAirspaces());
-		for (std::multimap<int, Airspace>::iterator it = airspaces.begin(); it != airspaces.end(); ) {
-			if ((*it).second.IsWithinAltLimits(floor, ceiling)) ++it;
-			else it = airspaces.erase(it);
-		}
-		LogMessage(std::format("Filtering airspaces on altitude... excluded: {}, remaining: {}", origAirspaces - GetNumOfAirspaces(), GetNumOfAirspaces()));
+	if (!airspaces.Empty()) {
+		const std::vector<AirspaceStore::Hot>& hot(airspaces.GetHotFields());
+		std::vector<unsigned char> outside(hot.size());
+		Parallel::For(hot.size(), [&](const size_t i) { outside[i] = !hot[i].IsWithinAltLimits(floor, ceiling); });
+		const size_t excluded(airspaces.Remove(outside));
+		LogMessage(std::format("Filtering airspaces on altitude... excluded: {}, remaining: {}", excluded, GetNumOfAirspaces()));
 	}
 
 	// Filter waypoints
-	if (!waypoints.empty()) {
-		const unsigned long origWaypoints(GetNumOfWaypoints());
-		for (std::multimap<int, Waypoint*>::iterator it = waypoints.begin(); it != waypoints.end(); ) {
-			Waypoint* w = (*it).second;
-			const Altitude altWptMt(w->GetAltitude(), true, true);
-
-			if (altWptMt >= floor && altWptMt <= ceiling) ++it;
-			else {
-				it = waypoints.erase(it);
-				delete(w);
-			}
+	if (!waypoints.Empty()) {
+		const std::vector<float>& altitudes(waypoints.GetAltitudes());
+		std::vector<unsigned char> outside(altitudes.size());
+		for (size_t i = 0; i < altitudes.size(); i++) {
+			const Altitude altWptMt(altitudes[i], true, true);
+			outside[i] = !(altWptMt >= floor && altWptMt <= ceiling);
 		}
-		LogMessage(std::format("Filtering waypoints on altitude... excluded: {}, remaining: {}", origWaypoints - GetNumOfWaypoints(), GetNumOfWaypoints()));
+		const size_t excluded(waypoints.Remove(outside));
+		LogMessage(std::format("Filtering waypoints on altitude... excluded: {}, remaining: {}", excluded, GetNumOfWaypoints()));
 	}
 	return true;
 }
 
-void AirspaceConverter::DoNotCalculateArcsAndCirconferences(const bool doNotCalcArcs /*= true*/) {
-	OpenAir::CalculateArcsAndCirconferences(!doNotCalcArcs);
+bool AirspaceConverter::PrefilterOnLatLonLimits(const double& topLat, const double& bottomLat, const double& leftLon, const double& rightLon, const bool clip /*= false*/) {
+	// Check if it is necessary to filter
+	context.latLonLimits.Disable();
+	if (topLat == 90 && bottomLat == -90 && leftLon == -180 && rightLon == 180) return true;
+
+	// Only valid limits are used by the readers
+	context.clipOnLatLonLimits = clip;
+	context.latLonLimits = Geometry::Limits(topLat, bottomLat, leftLon, rightLon);
+	return context.latLonLimits.IsValid();
 }
 
-void AirspaceConverter::SetOpenAirCoodinatesAutomatic() {
-	OpenAir::SetCoordinateType(OpenAir::CoordinateType::AUTO);
+bool AirspaceConverter::PrefilterOnAltitudeLimits(const Altitude& floor, const Altitude& ceiling) {
+	// Check if it is necessary to filter
+	context.filterOnAltitude = false;
+	if (floor.GetAltFt() <= -10000 && ceiling.IsUnlimited()) return true;
+
+	// Check if it is valid limits
+	if (ceiling < floor) return false;
+
+	context.altitudeFloor = floor;
+	context.altitudeCeiling = ceiling;
+	context.filterOnAltitude = true;
+	return true;
 }
 
-void AirspaceConverter::SetOpenAirCoodinatesInDecimalMinutes() {
-	OpenAir::SetCoordinateType(OpenAir::CoordinateType::DEG_DECIMAL_MIN);
+void AirspaceConverter::ClearPrefilters() {
+	context.latLonLimits.Disable();
+	context.clipOnLatLonLimits = false;
+	context.filterOnAltitude = false;
 }
 
-void AirspaceConverter::SetOpenAirCoodinatesInSeconds() {
-	OpenAir::SetCoordinateType(OpenAir::CoordinateType::DEG_MIN_SEC);
+bool AirspaceConverter::FilterOnCategories(const std::string& categories, const bool include /*= false*/) {
+	// Find the categories listed
+	std::vector<bool> listed(Airspace::UNDEFINED, false);
+	boost::tokenizer<boost::char_separator<char>> tokens(categories, boost::char_separator<char>(","));
+	for (const std::string& token : tokens) {
+		const std::string name(boost::trim_copy(token));
+		int category = Airspace::CLASSA;
+		while (category < Airspace::UNDEFINED && !boost::iequals(name, Airspace::CategoryName((Airspace::Type)category)) && !boost::iequals(name, Airspace::LongCategoryName((Airspace::Type)category))) category++;
+		if (category == Airspace::UNDEFINED) {
+			LogError("Unknown airspace category to filter: " + name);
+			return false;
+		}
+		listed[category] = true;
+	}
+
+	// Add them to the categories excluded, so they are skipped already while loading
+	if (context.excludedCategories.empty()) context.excludedCategories.resize(Airspace::UNDEFINED, false);
+	for (int category = Airspace::CLASSA; category < Airspace::UNDEFINED; category++)
+		if (listed[category] != include) context.excludedCategories[category] = true;
+
+	// Filter the airspaces already loaded
+	if (!airspaces.Empty()) {
+		std::vector<unsigned char> excluded;
+		excluded.reserve(airspaces.Size());
+		for (int category = Airspace::CLASSA; category < Airspace::UNDEFINED; category++)
+			excluded.insert(excluded.end(), airspaces.Count(category), context.excludedCategories[category]);
+		excluded.resize(airspaces.Size(), false); // Nothing excluded of undefined category
+		const size_t numExcluded(airspaces.Remove(excluded));
+		LogMessage(std::format("Filtering airspaces on category... excluded: {}, remaining: {}", numExcluded, GetNumOfAirspaces()));
+	}
+	return true;
 }
 
-bool AirspaceConverter::VerifyAltitudeOnTerrainMap(const double& lat, const double& lon, float& alt, const bool& blankAltitude, const bool& altitudeParsed, const int& line, const bool isSpike) {
-	double terrainAlt;
-	if (GetTerrainAltitudeMt(lat, lon, terrainAlt)) {
-		if (altitudeParsed) {
-			const double delta = isSpike ? alt - terrainAlt : fabs(alt - terrainAlt); // Spike such as an antenna, tower, VOR, etc: consider higher theresold in this case
-			if (isSpike ? delta > 100 || delta < 0 : terrainAlt > 5 ? delta > 10 : delta > 15) { // Consider bigger threshold if delta > 5 m (maybe it was really intended AMSL)
-				LogWarning(std::format("on line {}: detected altitude difference of: {} m respect ground, using terrain altitude: {} m", line, delta, terrainAlt));
-				alt = (float)terrainAlt;
-			}
-		} else {
-			if (blankAltitude) LogWarning(std::format("on line {}: blank elevation, using terrain altitude: {} m", line, terrainAlt));
-			else LogWarning(std::format("on line {}: invalid elevation, using terrain altitude: {} m", line,terrainAlt));
-			alt = (float)terrainAlt;
+bool AirspaceConverter::ValidateAirspaces(const bool repair /*= false*/) {
+	if (airspaces.Empty()) return true;
+
+	// Check each airspace with a sweep line, if requested try to repair it removing the spikes
+	enum Status : unsigned char { VALID = 0, REPAIRED, SELF_INTERSECTING };
+	std::vector<Status> status(airspaces.Size(), VALID);
+	airspaces.ParallelForEach([&](const size_t i, Airspace& airspace) {
+		if (!airspace.IsSelfIntersecting()) return;
+		status[i] = repair && airspace.RemoveSpikes() && airspace.GetNumberOfPoints() > 3 && !airspace.IsSelfIntersecting() ? REPAIRED : SELF_INTERSECTING;
+	});
+
+	// Report the results in order and remove the invalid ones if requested
+	unsigned long selfIntersecting(0), repaired(0);
+	std::vector<unsigned char> toRemove(status.size());
+	for (size_t i = 0; i < status.size(); i++) {
+		if (status[i] == VALID) continue;
+		const Airspace& airspace = airspaces.At(i);
+		if (status[i] == REPAIRED) {
+			repaired++;
+			LogWarning(std::format("removed spikes from airspace {} in {}", airspace.GetName(), airspace.GetSourceLocation()));
+			continue;
 		}
-		return true;
-	} 
-	if (blankAltitude) LogWarning(std::format("on line {}: blank elevation, waypoint out of loaded terrain maps: assuming AMSL", line));
-	else if (!altitudeParsed) LogWarning(std::format("on line {}: invalid elevation, waypoint out of loaded terrain maps: assuming AMSL", line));
-	return false;
+		selfIntersecting++;
+		if (repair) {
+			LogWarning(std::format("skip self intersecting airspace {} in {}", airspace.GetName(), airspace.GetSourceLocation()));
+			toRemove[i] = true;
+		} else LogWarning(std::format("self intersecting airspace {} in {}", airspace.GetName(), airspace.GetSourceLocation()));
+	}
+	const size_t removed(airspaces.Remove(toRemove));
+	LogMessage(std::format("Validating airspaces... self intersecting: {}, repaired: {}, removed: {}", selfIntersecting, repaired, removed));
+	return selfIntersecting == 0;
+}
+
+void AirspaceConverter::DissolveAirspaces() {
+	if (airspaces.Empty()) return;
+
+	// Group the airspaces having same category, class and vertical limits
+	std::map<std::tuple<int, int, std::string, std::string>, std::vector<Airspace*>> groupsMap;
+	for (Airspace& a : airspaces) {
+		groupsMap[std::make_tuple(a.GetType(), a.GetClass(), a.GetBaseAltitude().ToString(), a.GetTopAltitude().ToString())].push_back(&a);
+	}
+	std::vector<std::vector<Airspace*>*> groups;
+	for (auto& group : groupsMap) if (group.second.size() > 1) groups.push_back(&group.second);
+
+	// Merge the touching ones of each group in parallel
+	std::vector<size_t> merged(groups.size());
+	Parallel::For(groups.size(), [&](const size_t i) {
+		merged[i] = Airspace::Dissolve(*groups[i]);
+	});
+
+	// Remove the airspaces merged into others, left without points
+	unsigned long numMerged(0);
+	for (const size_t m : merged) numMerged += (unsigned long)m;
+	if (numMerged > 0) {
+		std::vector<unsigned char> empty(airspaces.Size());
+		std::as_const(airspaces).ParallelForEach([&empty](const size_t i, const Airspace& airspace) { empty[i] = airspace.GetNumberOfPoints() == 0; });
+		airspaces.Remove(empty);
+	}
+	LogMessage(std::format("Dissolving airspaces... merged: {}, remaining: {}", numMerged, GetNumOfAirspaces()));
+}
+
+void AirspaceConverter::FindAirspacesAt(const double lat, const double lon, std::vector<const Airspace*>& found) {
+	found.clear();
+	std::vector<size_t> candidates;
+	airspaces.Query(lat, lon, candidates);
+	for (const size_t i : candidates) {
+		const Airspace& airspace = airspaces.At(i);
+		if (airspace.Contains(lat, lon)) found.push_back(&airspace);
+	}
+}
+
+void AirspaceConverter::FindAirspacesIn(const Geometry::Limits& limits, std::vector<const Airspace*>& found) {
+	found.clear();
+	std::vector<size_t> candidates;
+	airspaces.Query(limits, candidates);
+	for (const size_t i : candidates) {
+		const Airspace& airspace = airspaces.At(i);
+		if (airspace.IsWithinLatLonLimits(limits)) found.push_back(&airspace);
+	}
+}
+
+// Airspace1,Category1,Base1,Top1,Source1,Airspace2,Category2,Base2,Top2,Source2,OverlapAreaKm2,OverlapBase,OverlapTop
+bool AirspaceConverter::AnalyzeOverlaps(const std::string& reportFile) const {
+	std::ofstream file;
+	file.open(reportFile, std::ios::out | std::ios::trunc | std::ios::binary);
+	if (!file.is_open() || file.bad()) {
+		LogError("Unable to open output file: " + reportFile);
+		return false;
+	}
+
+	// Find the horizontally overlapping pairs
+	std::vector<const Airspace*> list;
+	list.reserve(airspaces.Size());
+	for (const Airspace& a : airspaces) list.push_back(&a);
+	std::vector<Airspace::Overlap> overlaps;
+	const size_t skipped(Airspace::FindOverlaps(list, overlaps));
+
+	// Write them with their vertical overlap, if any
+	auto quoted = [](const std::string& text) {
+		std::string out("\"");
+		for (const char c : text) out += c == '"' ? std::string("\"\"") : std::string(1, c);
+		return out + '"';
+	};
+	auto describe = [&quoted](const Airspace& a) {
+		return std::format("{},{},{},{},{}", quoted(a.GetName()), a.GetCategoryName(), a.GetBaseAltitude().ToString(), a.GetTopAltitude().ToString(), quoted(a.GetSourceLocation()));
+	};
+	file << "Airspace1,Category1,Base1,Top1,Source1,Airspace2,Category2,Base2,Top2,Source2,OverlapAreaKm2,OverlapBase,OverlapTop\r\n";
+	unsigned long alsoVertically(0);
+	for (const Airspace::Overlap& overlap : overlaps) {
+		const Airspace& a = *list[overlap.first];
+		const Airspace& b = *list[overlap.second];
+		file << describe(a) << ',' << describe(b) << ',' << std::format("{:.3f}", overlap.areaKm2) << ',';
+		if (a.GetBaseAltitude() < b.GetTopAltitude() && b.GetBaseAltitude() < a.GetTopAltitude()) {
+			alsoVertically++;
+			file << (a.GetBaseAltitude() < b.GetBaseAltitude() ? b : a).GetBaseAltitude().ToString() << ',' << (a.GetTopAltitude() < b.GetTopAltitude() ? a : b).GetTopAltitude().ToString();
+		} else file << ',';
+		file << "\r\n";
+	}
+	file.close();
+	LogMessage(std::format("Analyzing overlaps... overlapping pairs: {}, also vertically: {}, skipped airspaces: {}", overlaps.size(), alsoVertically, skipped));
+	return true;
+}
+
+bool AirspaceConverter::SimplifyAirspaces(const double toleranceMt, const size_t maxPoints /*= 0*/) {
+	// Check if it is valid parameters
+	if (toleranceMt < 0 || (maxPoints > 0 && maxPoints < 3) || (toleranceMt == 0 && maxPoints == 0)) return false;
+	if (airspaces.Empty()) return true;
+
+	// Simplify the airspaces in parallel
+	std::vector<size_t> pointsBefore(airspaces.Size()), pointsAfter(airspaces.Size());
+	std::vector<unsigned char> simplified(airspaces.Size()); // Not vector<bool> because written concurrently
+	airspaces.ParallelForEach([&](const size_t i, Airspace& airspace) {
+		pointsBefore[i] = airspace.GetNumberOfPoints();
+		simplified[i] = airspace.Simplify(toleranceMt, maxPoints);
+		pointsAfter[i] = airspace.GetNumberOfPoints();
+	});
+
+	// Report the ones left with more points than requested, which could not be simplified without intersecting themselves
+	unsigned long numSimplified(0), numOverLimit(0), totalBefore(0), totalAfter(0);
+	for (size_t i = 0; i < simplified.size(); i++) {
+		if (simplified[i]) numSimplified++;
+		else if (maxPoints > 0 && pointsAfter[i] > maxPoints + 1) { // Plus the closing one
+			numOverLimit++;
+			const Airspace& airspace = airspaces.At(i);
+			LogWarning(std::format("unable to simplify airspace {} in {} to {} points without self intersections", airspace.GetName(), airspace.GetSourceLocation(), maxPoints));
+		}
+		totalBefore += (unsigned long)pointsBefore[i];
+		totalAfter += (unsigned long)pointsAfter[i];
+	}
+	LogMessage(std::format("Simplifying airspaces... simplified: {}, over the max points: {}, points before: {}, after: {}", numSimplified, numOverLimit, totalBefore, totalAfter));
+	return true;
+}
+
+bool AirspaceConverter::SetArcsFittingTolerance(const double toleranceMt) {
+	if (toleranceMt <= 0 || toleranceMt > 100) return false;
+	context.arcsFittingToleranceMt = toleranceMt;
+	return true;
+}
+
+bool AirspaceConverter::SetResolution(const double resolutionNM) {
+	if (resolutionNM <= 0 || resolutionNM > 10) return false;
+	context.resolution = resolutionNM * Geometry::NM2RAD;
+	return true;
+}
+
+void AirspaceConverter::SetNumOfThreads(const unsigned int threads) {
+	Parallel::SetNumOfThreads(threads);
+}
+
+unsigned int AirspaceConverter::GetNumOfThreads() {
+	return Parallel::GetNumOfThreads();
 }
 
 int AirspaceConverter::VersionToNumber(const std::string& versionString) {
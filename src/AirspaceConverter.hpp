@@ -21,11 +21,9 @@
 #include <vector>
 #include <map>
 #include <istream>
-
-class Airspace;
-class Altitude;
-class Waypoint;
-class RasterMap;
+#include "AirspaceStore.hpp"
+#include "WaypointStore.hpp"
+#include "ConversionContext.hpp"
 
 class AirspaceConverter {
 public:
@@ -57,7 +55,7 @@ public:
 	static std::istream& SafeGetline(std::istream& is, std::string& line, bool& isCRLF);
 	static OutputType DetermineType(const std::string& filename);
 	static bool PutTypeExtension(const OutputType type, std::string& filename);
-	static bool ParseAltitude(const std::string& text, const bool isTop, Airspace& airspace);
+	static bool ParseAltitude(const std::string& text, const bool isTop, Airspace& airspace, const double QNHhPa);
 	inline static bool isDigit(const char c) { return (c >= '0' && c <= '9'); }
 	static std::string GetCurrentDateString();
 	static std::string GetFullCreationDateTimeString();
@@ -75,31 +73,49 @@ public:
 	void UnloadRasterMaps();
 	void LoadWaypoints();
 	void UnloadWaypoints();
-	void SetQNH(const double newQNHhPa);
+	void SetQNH(const double newQNHhPa); // Also for the airspaces already loaded
 	double GetQNH() const;
-	static bool AddTerrainMap(const std::string& filename);
-	inline static int GetNumOfTerrainMaps() { return (int)terrainMaps.size(); }
-	static bool GetTerrainAltitudeMt(const double& lat, const double& lon, double& alt);
-	static void ClearTerrainMaps();
-	inline static void SetDefaultTerrainAlt(const double& defaultAltMt) { defaultTerrainAltitudeMt = defaultAltMt; }
-	inline static double GetDefaultTerrainAlt() { return defaultTerrainAltitudeMt; }
+	bool AddTerrainMap(const std::string& filename);
+	inline int GetNumOfTerrainMaps() const { return (int)context.terrainMaps->Size(); }
+	void ClearTerrainMaps();
+	inline std::shared_ptr<const TerrainMaps> GetTerrainMaps() const { return context.terrainMaps; } // To share the loaded maps with other converters
+	inline void SetTerrainMaps(std::shared_ptr<const TerrainMaps> maps) { if (maps) context.terrainMaps = maps; }
+	inline void SetDefaultTerrainAlt(const double& defaultAltMt) { context.defaultTerrainAltitudeMt = defaultAltMt; }
+	inline double GetDefaultTerrainAlt() const { return context.defaultTerrainAltitudeMt; }
+	inline const ConversionContext& GetContext() const { return context; }
 	bool Convert();
 	inline bool IsConversionDone() const { return conversionDone; }
 	inline OutputType GetOutputType() const { return DetermineType(outputFile); }
 	inline bool SetOutputType(const OutputType type) { return PutTypeExtension(type, outputFile); }
 	inline void SetOutputFile(const std::string& outputFilename) { outputFile = outputFilename; }
 	inline std::string GetOutputFile() const { return outputFile; }
-	inline unsigned long GetNumOfAirspaces() const { return (unsigned long)airspaces.size(); }
-	inline unsigned long GetNumOfWaypoints() const { return (unsigned long)waypoints.size(); }
-	bool FilterOnLatLonLimits(const double& topLat, const double& bottomLat, const double& leftLon, const double& rightLon);
+	inline unsigned long GetNumOfAirspaces() const { return (unsigned long)airspaces.Size(); }
+	inline unsigned long GetNumOfWaypoints() const { return (unsigned long)waypoints.Size(); }
+	bool FilterOnLatLonLimits(const double& topLat, const double& bottomLat, const double& leftLon, const double& rightLon, const bool clip = false);
 	bool FilterOnAltitudeLimits(const Altitude& floor, const Altitude& ceiling);
+	bool PrefilterOnLatLonLimits(const double& topLat, const double& bottomLat, const double& leftLon, const double& rightLon, const bool clip = false); // Skip already while loading what FilterOnLatLonLimits() would remove
+	bool PrefilterOnAltitudeLimits(const Altitude& floor, const Altitude& ceiling); // Skip already while loading what FilterOnAltitudeLimits() would remove
+	void ClearPrefilters(); // The prefilters stay set also for the next loads, until cleared here
+	bool FilterOnCategories(const std::string& categories, const bool include = false); // Comma separated category names to exclude or the only ones to include, also while loading
+	inline void ClearCategoriesFilter() { context.excludedCategories.clear(); }
+	bool ValidateAirspaces(const bool repair = false);
+	void DissolveAirspaces();
+	bool AnalyzeOverlaps(const std::string& reportFile) const;
+	void FindAirspacesAt(const double lat, const double lon, std::vector<const Airspace*>& found); // The loaded airspaces containing the point, in iteration order
+	void FindAirspacesIn(const Geometry::Limits& limits, std::vector<const Airspace*>& found); // The loaded airspaces with any part within the limits, in iteration order, all if the limits are not valid
+	bool SimplifyAirspaces(const double toleranceMt, const size_t maxPoints = 0);
 	inline void ProcessTracksAsAirspaces(const bool treatTracksAsAirspaces = true) { processLineStrings = treatTracksAsAirspaces; }
-	static void DoNotCalculateArcsAndCirconferences(const bool doNotCalcArcs = true);
-	static void SetOpenAirCoodinatesAutomatic();
-	static void SetOpenAirCoodinatesInDecimalMinutes();
-	static void SetOpenAirCoodinatesInSeconds();
-	static bool VerifyAltitudeOnTerrainMap(const double& lat, const double& lon, float& alt, const bool& blankAltitude, const bool& altitudeParsed, const int& line, const bool isSpike = false);
+	inline void DoNotCalculateArcsAndCirconferences(const bool doNotCalcArcs = true) { context.calculateArcs = !doNotCalcArcs; }
+	bool SetArcsFittingTolerance(const double toleranceMt);
+	bool SetResolution(const double resolutionNM); // Maximum distance between the points when discretizing arcs and circles
+	inline double GetResolution() const { return context.resolution * Geometry::RAD2NM; } // [NM]
+	inline void CalculateSurfacesOnSphere(const bool onSphere = true) { context.surfacesOnSphere = onSphere; }
+	inline void SetOpenAirCoodinatesAutomatic() { context.openAirCoordinates = ConversionContext::AUTO; }
+	inline void SetOpenAirCoodinatesInDecimalMinutes() { context.openAirCoordinates = ConversionContext::DEG_DECIMAL_MIN; }
+	inline void SetOpenAirCoodinatesInSeconds() { context.openAirCoordinates = ConversionContext::DEG_MIN_SEC; }
 	static bool CheckForNewVersion(int& versionDifference);
+	static void SetNumOfThreads(const unsigned int threads); // Threads used by all the converters, 0 for one per core, 1 to work serially
+	static unsigned int GetNumOfThreads();
 
 	static const std::vector<std::string> disclaimer;
 	static const std::string basePath;
@@ -113,10 +129,9 @@ private:
 	static const std::string Detect_cGPSmapperPath();
 	static int VersionToNumber(const std::string& vesionString);
 
-	std::multimap<int, Airspace> airspaces;
-	std::multimap<int, Waypoint*> waypoints;
-	static std::vector<RasterMap*> terrainMaps;
-	static double defaultTerrainAltitudeMt;
+	AirspaceStore airspaces;
+	WaypointStore waypoints;
+	ConversionContext context;
 	std::string outputFile;
 	std::vector<std::string> airspaceFiles, terrainRasterMapFiles, waypointFiles;
 	bool conversionDone;
@@ -0,0 +1,139 @@
+//============================================================================
+// AirspaceConverter
+// Web         : https://www.alus.it/AirspaceConverter
+// Repository  : https://github.com/alus-it/AirspaceConverter.git
+// License     : GNU GPL v3
+//
+// This source file is part of AirspaceConverter project
+//============================================================================
+
+#include "AirspaceStore.hpp"
+#include <algorithm>
+#include <cassert>
+#include <boost/geometry.hpp>
+#include <boost/geometry/index/rtree.hpp>
+
+typedef boost::geometry::model::point<double, 2, boost::geometry::cs::cartesian> PointLonLat;
+typedef boost::geometry::model::box<PointLonLat> BoxLonLat;
+
+// The boxes across the antimeridian or around a pole are taken as covering all the longitudes
+struct AirspaceStore::SpatialIndex {
+	explicit SpatialIndex(const std::vector<std::pair<BoxLonLat, size_t>>& boxes) : rtree(boxes.begin(), boxes.end()) {} // Packed at once, better than inserting one by one
+	const boost::geometry::index::rtree<std::pair<BoxLonLat, size_t>, boost::geometry::index::rstar<16>> rtree;
+};
+
+void AirspaceStore::Hot::Set(const Airspace& airspace) {
+	type = airspace.GetType();
+	base = airspace.GetBaseAltitude();
+	top = airspace.GetTopAltitude();
+	box = airspace.GetBoundingBox();
+}
+
+void AirspaceStore::Insert(Airspace&& airspace) {
+	const int category(airspace.GetType());
+	assert(category >= 0 && category < NUM_OF_CATEGORIES);
+	categories[category].push_back(std::move(airspace));
+	categories[category].back().SetArena(nullptr); // The geometries built later, e.g. simplifying, would never release their memory in the arena
+	numOfAirspaces++;
+	Changed();
+}
+
+void AirspaceStore::Clear() {
+	for (std::vector<Airspace>& category : categories) std::vector<Airspace>().swap(category);
+	numOfAirspaces = 0;
+	hot.clear();
+	hotValid = true;
+	index.reset();
+	arena = std::make_shared<Arena>();
+	StringPool::Purge(); // The names of the airspaces destroyed are no longer needed
+}
+
+size_t AirspaceStore::Remove(const std::vector<unsigned char>& toRemove) {
+	assert(toRemove.size() == numOfAirspaces);
+	size_t i(0), totalKept(0);
+	for (std::vector<Airspace>& category : categories) {
+		size_t kept(0);
+		for (size_t pos = 0; pos < category.size(); pos++, i++) {
+			if (toRemove[i]) continue;
+			if (kept != pos) category[kept] = std::move(category[pos]);
+			if (hotValid && totalKept != i) hot[totalKept] = hot[i]; // Keep the hot fields in step
+			kept++;
+			totalKept++;
+		}
+		category.erase(category.begin() + kept, category.end());
+	}
+	const size_t removed(numOfAirspaces - totalKept);
+	numOfAirspaces = totalKept;
+	if (hotValid) hot.resize(numOfAirspaces);
+	if (removed > 0) index.reset(); // The positions have changed
+	return removed;
+}
+
+const Airspace& AirspaceStore::At(size_t i) const {
+	assert(i < numOfAirspaces);
+	int c(0);
+	while (i >= categories[c].size()) i -= categories[c++].size();
+	return categories[c][i];
+}
+
+const std::vector<AirspaceStore::Hot>& AirspaceStore::GetHotFields() {
+	if (hotValid) return hot;
+	hot.resize(numOfAirspaces);
+	ParallelForEach([this](const size_t i, const Airspace& airspace) { hot[i].Set(airspace); });
+	hotValid = true;
+	return hot;
+}
+
+const AirspaceStore::SpatialIndex& AirspaceStore::GetIndex() {
+	if (index) return *index;
+	const std::vector<Hot>& hotFields(GetHotFields());
+	std::vector<std::pair<BoxLonLat, size_t>> boxes;
+	boxes.reserve(hotFields.size());
+	for (size_t i = 0; i < hotFields.size(); i++) {
+		const Geometry::Box& box(hotFields[i].box);
+		if (box.IsEmpty()) continue; // Never touching anything
+		const bool allLons(box.IsAllLongitudes());
+		boxes.emplace_back(BoxLonLat(PointLonLat(allLons ? -180 : box.minLon, box.minLat), PointLonLat(allLons ? 180 : box.maxLon, box.maxLat)), i);
+	}
+	index = std::make_shared<const SpatialIndex>(boxes);
+	return *index;
+}
+
+void AirspaceStore::Query(const Geometry::Limits& limits, std::vector<size_t>& found) {
+	found.clear();
+	if (!limits.IsValid()) {
+		const std::vector<Hot>& hotFields(GetHotFields());
+		for (size_t i = 0; i < hotFields.size(); i++) if (!hotFields[i].box.IsEmpty()) found.push_back(i);
+		return;
+	}
+	const SpatialIndex& spatialIndex(GetIndex());
+	const double top(limits.GetTopLatitudeLimit()), bottom(limits.GetBottomLatitudeLimit());
+	const double left(limits.GetLeftLongitudeLimit()), right(limits.GetRightLongitudeLimit());
+	std::vector<BoxLonLat> areas;
+	if (limits.IsAcrossAntiGreenwich()) { // Split on the antimeridian
+		areas.emplace_back(PointLonLat(left, bottom), PointLonLat(180, top));
+		areas.emplace_back(PointLonLat(-180, bottom), PointLonLat(right, top));
+	} else areas.emplace_back(PointLonLat(left, bottom), PointLonLat(right, top));
+	for (const BoxLonLat& area : areas)
+		for (auto it = spatialIndex.rtree.qbegin(boost::geometry::index::intersects(area)); it != spatialIndex.rtree.qend(); ++it) found.push_back(it->second);
+	std::sort(found.begin(), found.end());
+	if (areas.size() > 1) found.erase(std::unique(found.begin(), found.end()), found.end());
+}
+
+void AirspaceStore::Query(const double lat, const double lon, std::vector<size_t>& found) {
+	found.clear();
+	const SpatialIndex& spatialIndex(GetIndex());
+	const PointLonLat point(lon, lat);
+	for (auto it = spatialIndex.rtree.qbegin(boost::geometry::index::intersects(point)); it != spatialIndex.rtree.qend(); ++it) found.push_back(it->second);
+	std::sort(found.begin(), found.end());
+}
+
+std::vector<size_t> AirspaceStore::Offsets() const {
+	std::vector<size_t> offsets(NUM_OF_CATEGORIES + 1, 0);
+	for (int c = 0; c < NUM_OF_CATEGORIES; c++) offsets[c + 1] = offsets[c] + categories[c].size();
+	return offsets;
+}
+
+int AirspaceStore::Locate(const std::vector<size_t>& offsets, const size_t i) {
+	return (int)(std::upper_bound(offsets.begin(), offsets.end(), i) - offsets.begin()) - 1;
+}
@@ -0,0 +1,115 @@
+//============================================================================
+// AirspaceConverter
+// Web         : https://www.alus.it/AirspaceConverter
+// Repository  : https://github.com/alus-it/AirspaceConverter.git
+// License     : GNU GPL v3
+//
+// This source file is part of AirspaceConverter project
+//============================================================================
+
+#pragma once
+#include <vector>
+#include <iterator>
+#include <memory>
+#include "Airspace.hpp"
+#include "Parallel.hpp"
+#include "Arena.hpp"
+
+// Airspaces kept in one contiguous vector per category, visited by category and then in order of insertion
+class AirspaceStore {
+public:
+	// The few fields needed to filter the airspaces, kept apart so they can be scanned without touching the airspaces
+	struct Hot {
+		Hot() : type(Airspace::UNDEFINED) {}
+		void Set(const Airspace& airspace);
+		inline bool IsWithinLatLonLimits(const Geometry::Limits& limits) const { return box.IsWithinLimits(limits); } // True if all the points are within the limits
+		inline bool IsOutsideLatLonLimits(const Geometry::Limits& limits) const { return box.IsOutsideLimits(limits); } // True if no point is within the limits
+		inline bool IsWithinAltLimits(const Altitude& floor, const Altitude& ceil) const { return Airspace::IsWithinAltLimits(base, top, floor, ceil); }
+
+		Airspace::Type type;
+		Geometry::Box box; // Bounding box of the points, empty if there are no points
+		Altitude base, top;
+	};
+
+	template<typename A, typename Store>
+	class Iterator {
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = Airspace;
+		using difference_type = std::ptrdiff_t;
+		using pointer = A*;
+		using reference = A&;
+
+		Iterator(Store* s, const int c, const size_t p) : store(s), category(c), pos(p) { SkipEmpty(); }
+		inline reference operator*() const { return store->categories[category][pos]; }
+		inline pointer operator->() const { return &store->categories[category][pos]; }
+		inline Iterator& operator++() { ++pos; SkipEmpty(); return *this; }
+		inline Iterator operator++(int) { Iterator it(*this); ++(*this); return it; }
+		inline bool operator==(const Iterator& other) const { return category == other.category && pos == other.pos; }
+
+	private:
+		inline void SkipEmpty() { while (category < NUM_OF_CATEGORIES && pos >= store->categories[category].size()) { ++category; pos = 0; } }
+		Store* store;
+		int category;
+		size_t pos;
+	};
+	typedef Iterator<Airspace, AirspaceStore> iterator;
+	typedef Iterator<const Airspace, const AirspaceStore> const_iterator;
+
+	AirspaceStore() : arena(std::make_shared<Arena>()), numOfAirspaces(0), hotValid(true) {}
+
+	void Insert(Airspace&& airspace); // Add it at the end of its category, from now on its new geometries go on the heap
+	void Clear(); // Destroy all the airspaces and start a new arena, the old one goes with the last geometry using it, then release the unused texts of the StringPool
+	inline const std::shared_ptr<Arena>& GetArena() const { return arena; } // Where the readers should allocate the geometries of the airspaces of this store
+	size_t Remove(const std::vector<unsigned char>& toRemove); // Remove the airspaces flagged, in iteration order, moving each remaining one only once, the memory of their geometries in the arena is not reused
+	inline size_t Size() const { return numOfAirspaces; }
+	inline bool Empty() const { return numOfAirspaces == 0; }
+	inline size_t Count(const int category) const { return categories[category].size(); }
+	inline const std::vector<Airspace>& Category(const int category) const { return categories[category]; }
+	const Airspace& At(size_t i) const; // The i-th airspace in iteration order
+	const std::vector<Hot>& GetHotFields(); // In iteration order, rebuilt only if the airspaces may have changed
+	void Query(const Geometry::Limits& limits, std::vector<size_t>& found); // Position in iteration order, ascending, of the airspaces with the bounding box touching the limits
+	void Query(const double lat, const double lon, std::vector<size_t>& found); // Position in iteration order, ascending, of the airspaces with the bounding box containing the point
+
+	// Iteration with write access, the hot fields and the spatial index will be rebuilt the next time they are requested
+	inline iterator begin() { Changed(); return iterator(this, 0, 0); }
+	inline iterator end() { return iterator(this, NUM_OF_CATEGORIES, 0); }
+	inline const_iterator begin() const { return const_iterator(this, 0, 0); }
+	inline const_iterator end() const { return const_iterator(this, NUM_OF_CATEGORIES, 0); }
+
+	// Call body(i, airspace) for each airspace using all the available cores, i is the position in iteration order
+	template<typename Function>
+	void ParallelForEach(const Function& body) {
+		Changed();
+		const std::vector<size_t> offsets(Offsets());
+		Parallel::For(numOfAirspaces, [&](const size_t i) {
+			const int c = Locate(offsets, i);
+			body(i, categories[c][i - offsets[c]]);
+		});
+	}
+
+	template<typename Function>
+	void ParallelForEach(const Function& body) const {
+		const std::vector<size_t> offsets(Offsets());
+		Parallel::For(numOfAirspaces, [&](const size_t i) {
+			const int c = Locate(offsets, i);
+			body(i, categories[c][i - offsets[c]]);
+		});
+	}
+
+private:
+	struct SpatialIndex; // R-tree of the bounding boxes, defined only in the source to keep Boost out of this header
+
+	static const int NUM_OF_CATEGORIES = Airspace::UNDEFINED + 1;
+	inline void Changed() { hotValid = false; index.reset(); }
+	const SpatialIndex& GetIndex();
+	std::vector<size_t> Offsets() const; // Position in iteration order of the first airspace of each category, plus the total
+	static int Locate(const std::vector<size_t>& offsets, const size_t i);
+
+	std::shared_ptr<Arena> arena; // Of the airspaces read since the last Clear()
+	std::vector<Airspace> categories[NUM_OF_CATEGORIES];
+	size_t numOfAirspaces;
+	std::vector<Hot> hot;
+	bool hotValid;
+	std::shared_ptr<const SpatialIndex> index; // Built at the first query after any change
+};
@@ -5,7 +5,6 @@ const double Altitude::FEET2METER = 0.3048; // 1 Ft = 0.3048 m
 const double Altitude::K1 = 0.190263;
 const double Altitude::K2 = 8.417286e-5;
 const double Altitude::QNE = 1013.25;
-double Altitude::QNH = QNE;
 
 Altitude::Altitude(): refIsMsl(false), fl(0), altFt(0), altMt(0), isUnlimited(false) {}
 
@@ -17,14 +16,14 @@ Altitude::Altitude(const double value, bool isInMeters /* = false */, bool isMSL
 	isUnlimited(false) {
 }
 
-Altitude::Altitude(const int FL) :
+Altitude::Altitude(const int FL, const double QNHhPa /*= QNE*/) :
 	refIsMsl(true),
 	fl(FL),
 	altFt(FL * 100),
 	altMt(altFt * FEET2METER),
 	isUnlimited(false) {
-	if (QNH != QNE) {
-		altMt = QNEaltitudeToQNHaltitude(altMt);
+	if (QNHhPa != QNE) {
+		altMt = QNEaltitudeToQNHaltitude(altMt, QNHhPa);
 		altFt = (int)(altMt / FEET2METER);
 	}
 }
@@ -33,21 +32,21 @@ double Altitude::QNEaltitudeToStaticPressure(const double alt) {
 	return std::pow((std::pow(QNE, K1) - K2*alt), 1.0 / K1);
 }
 
-double Altitude::StaticPressureToQNHaltitude(const double ps) {
-	return (std::pow(QNH, K1) - std::pow(ps, K1)) / K2;
+double Altitude::StaticPressureToQNHaltitude(const double ps, const double QNHhPa) {
+	return (std::pow(QNHhPa, K1) - std::pow(ps, K1)) / K2;
 }
 
-double Altitude::QNEaltitudeToQNHaltitude(const double ps) {
-	return StaticPressureToQNHaltitude(QNEaltitudeToStaticPressure(ps));
+double Altitude::QNEaltitudeToQNHaltitude(const double ps, const double QNHhPa) {
+	return StaticPressureToQNHaltitude(QNEaltitudeToStaticPressure(ps), QNHhPa);
 }
 
-void Altitude::SetFlightLevel(const int FL) {
+void Altitude::SetFlightLevel(const int FL, const double QNHhPa /*= QNE*/) {
 	fl = FL;
 	refIsMsl = true;
 	altFt = FL * 100;
 	altMt = altFt * FEET2METER;
-	if (QNH != QNE) {
-		altMt = QNEaltitudeToQNHaltitude(altMt);
+	if (QNHhPa != QNE) {
+		altMt = QNEaltitudeToQNHaltitude(altMt, QNHhPa);
 		altFt = (int)(altMt / FEET2METER);
 	}
 }
@@ -17,13 +17,14 @@ class Altitude {
 public:
 	Altitude();
 	Altitude(const double value, bool isInMeters = false, bool isMSL = true);
-    Altitude(const int FL);
+    Altitude(const int FL, const double QNHhPa = QNE);
 
 	inline void SetAltFt(const int ft, const bool isAMSL = true) { refIsMsl = isAMSL; altMt = ft*FEET2METER; altFt = ft; fl = 0; isUnlimited = false; }
 	inline void SetAltMt(const double mt, const bool isAMSL = true) { refIsMsl = isAMSL;  altFt = (int)(mt / FEET2METER); altMt = mt; fl = 0; isUnlimited = false; }
-	void SetFlightLevel(const int FL);
+	void SetFlightLevel(const int FL, const double QNHhPa = QNE); // The altitude is calculated with the given QNH
 	inline void SetGND() { refIsMsl = false; altMt = 0; altFt = 0; fl = 0; isUnlimited = false; }
-	inline void SetUnlimited(bool unlimited = true) { if (unlimited) SetFlightLevel(600); isUnlimited = unlimited; }
+	inline void SetUnlimited(bool unlimited = true, const double QNHhPa = QNE) { if (unlimited) SetFlightLevel(600, QNHhPa); isUnlimited = unlimited; }
+	inline void ApplyQNH(const double QNHhPa) { if (fl != 0) SetFlightLevel(fl, QNHhPa); } // Only the flight levels depend on the QNH
 	inline bool IsAMSL() const { return refIsMsl; }
 	inline bool IsAGL() const { return !refIsMsl; }
 	inline bool IsFL() const { return fl != 0; }
@@ -40,20 +41,18 @@ public:
 	bool operator!=(const Altitude& other) const;
 	
 	const std::string ToString() const;
-	inline static void SetQNH(const double QNHmb) { QNH = QNHmb; }
-	inline static double GetQNH() { return QNH; }
 	static const double FEET2METER;
+	static const double QNE; // [hPa] standard pressure at the sea level
 
 private:
 	static double QNEaltitudeToStaticPressure(const double alt);
-	static double StaticPressureToQNHaltitude(const double ps);
-	static double QNEaltitudeToQNHaltitude(const double ps);
+	static double StaticPressureToQNHaltitude(const double ps, const double QNHhPa);
+	static double QNEaltitudeToQNHaltitude(const double ps, const double QNHhPa);
 
 	bool refIsMsl;
 	int fl; // Flight level
 	int altFt; // Alt in feet
 	double altMt; // Alt in meters
 	bool isUnlimited;
-	static const double K1, K2, QNE;
-	static double QNH;
+	static const double K1, K2;
 };
@@ -0,0 +1,21 @@
+//============================================================================
+// AirspaceConverter
+// Web         : https://www.alus.it/AirspaceConverter
+// Repository  : https://github.com/alus-it/AirspaceConverter.git
+// License     : GNU GPL v3
+//
+// This source file is part of AirspaceConverter project
+//============================================================================
+
+#include "Arena.hpp"
+
+size_t Arena::GetAllocatedBytes() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return allocatedBytes;
+}
+
+void* Arena::do_allocate(size_t bytes, size_t alignment) {
+	std::lock_guard<std::mutex> lock(mutex);
+	allocatedBytes += bytes;
+	return buffer.allocate(bytes, alignment);
+}
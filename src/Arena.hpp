@@ -0,0 +1,52 @@
+//============================================================================
+// AirspaceConverter
+// Web         : https://www.alus.it/AirspaceConverter
+// Repository  : https://github.com/alus-it/AirspaceConverter.git
+// License     : GNU GPL v3
+//
+// This source file is part of AirspaceConverter project
+//============================================================================
+
+#pragma once
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+
+// Memory of the geometries read from one dataset: allocations only move forward in big blocks and single deallocations do nothing.
+// Each geometry allocated with Allocator keeps its arena alive, so it is released at once when the last of them is destroyed.
+// Memory is never reused: only what is built while reading should go here, the geometries built later on the heap.
+class Arena : public std::pmr::memory_resource {
+public:
+	// Allocator for std::allocate_shared(), copied in the control block of the shared pointer to keep the arena alive
+	template<typename T>
+	class Allocator {
+	public:
+		typedef T value_type;
+		explicit Allocator(const std::shared_ptr<Arena>& datasetArena) : arena(datasetArena) {}
+		template<typename U>
+		Allocator(const Allocator<U>& other) : arena(other.arena) {}
+		inline T* allocate(const size_t n) { return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T))); }
+		inline void deallocate(T*, const size_t) {} // Released only all together
+		template<typename U>
+		inline bool operator==(const Allocator<U>& other) const { return arena == other.arena; }
+
+	private:
+		template<typename U> friend class Allocator;
+		std::shared_ptr<Arena> arena;
+	};
+
+	Arena() : allocatedBytes(0) {}
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	size_t GetAllocatedBytes() const;
+
+private:
+	void* do_allocate(size_t bytes, size_t alignment) override; // Thread safe
+	inline void do_deallocate(void*, size_t, size_t) override {} // Released only all together
+	inline bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+	mutable std::mutex mutex;
+	std::pmr::monotonic_buffer_resource buffer;
+	size_t allocatedBytes;
+};
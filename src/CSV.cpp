@@ -27,6 +27,8 @@
 #include "AirspaceConverter.hpp"
 #include "Waypoint.hpp"
 #include "Airfield.hpp"
+#include "WaypointStore.hpp"
+#include "ConversionContext.hpp"
 #include "Airspace.hpp"
 #include "Geometry.hpp"
 #include <fstream>
@@ -37,8 +39,9 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/tokenizer.hpp>
 
-CSV::CSV(std::multimap<int,Waypoint*>& waypointsMap):
-	waypoints(waypointsMap) {
+CSV::CSV(WaypointStore& waypointsStore, const ConversionContext& conversionContext):
+	waypoints(waypointsStore),
+	context(conversionContext) {
 }
 
 bool CSV::ParseStyle(const std::string& text, int& type) {
@@ -300,7 +303,7 @@ bool CSV::Read(const std::string& fileName) {
 	int type;
 	double latitude, longitude;
 	float altitude = 0;
-	const bool terrainMapsPresent(AirspaceConverter::GetNumOfTerrainMaps() > 0);
+	const bool terrainMapsPresent(!context.terrainMaps->Empty());
 
 	while (!input.eof() && input.good()) {
 
@@ -388,7 +391,13 @@ bool CSV::Read(const std::string& fileName) {
 
 		// Altitude verification against terrain raster map
 		if (terrainMapsPresent && type > Waypoint::WaypointType::normal) // Unknown and normal waypoints skipped
-			AirspaceConverter::VerifyAltitudeOnTerrainMap(latitude,longitude,altitude,blankAltitude,altitudeParsed,linecount,type >= Waypoint::WaypointType::mtTop && type <= Waypoint::WaypointType::dam);
+			context.VerifyAltitudeOnTerrainMap(latitude,longitude,altitude,blankAltitude,altitudeParsed,linecount,type >= Waypoint::WaypointType::mtTop && type <= Waypoint::WaypointType::dam);
+
+		// Skip it if it is going to be filtered out anyway, it is still a valid waypoint so the header is not anymore expected
+		if (context.IsWaypointExcluded(Geometry::LatLon(latitude, longitude), altitude)) {
+			firstWaypointFound = true;
+			continue;
+		}
 
 		// If it's an airfield...
 		if(Waypoint::IsTypeAirfield((Waypoint::WaypointType)type)) { // check & fix: Waypoint.hpp:IsTypeAirfield()
@@ -421,17 +430,17 @@ bool CSV::Read(const std::string& fileName) {
 			assert(token != tokens.end());
 
 			// Build the airfield (for now without runway dir and length and radio freq)
-			Airfield* airfield = new Airfield(name, code, country, latitude, longitude, altitude, type, description);
+			Airfield airfield(name, code, country, latitude, longitude, altitude, type, description);
 #if 0
 			if (altRadioFreq > 0) {
 				assert(radioFreq > 0);
 				if (altRadioFreq == radioFreq) AirspaceConverter::LogWarning(std::format("on line {}: skipping repeated secondary radio frequency for airfield.", linecount));
-				else airfield->SetOtherFrequency(altRadioFreq);
+				else airfield.SetOtherFrequency(altRadioFreq);
 			}
 #endif
 
-			// Add it to the multimap
-			waypoints.insert(std::pair<int, Waypoint*>(type, (Waypoint*)airfield));
+			// Add it to the store
+			waypoints.Add(airfield);
 
 		} else { // If it's NOT an airfield...
 			token++; // Skip Declination
@@ -456,14 +465,14 @@ bool CSV::Read(const std::string& fileName) {
 			assert(token != tokens.end());
 
 			// Build the waypoint
-			Waypoint* waypoint = new Waypoint(name, code, country, latitude, longitude, altitude, type, description);
+			Waypoint waypoint(name, code, country, latitude, longitude, altitude, type, description);
 
 #if 0
-			if (radioFreq > 0) waypoint->SetOtherFrequency(radioFreq);
+			if (radioFreq > 0) waypoint.SetOtherFrequency(radioFreq);
 #endif
 
-			// Add it to the multimap
-			waypoints.insert(std::pair<int, Waypoint*>(type, waypoint));
+			// Add it to the store
+			waypoints.Add(waypoint);
 		}
 
 		// Make sure that at this point we already found a valid waypoint so the header is not anymore expected
@@ -475,7 +484,7 @@ bool CSV::Read(const std::string& fileName) {
 
 // Type,Name,Ident,Lat,Lon,Elev,Decl,Label,Desc,Country,Range,ModificationTime,SourceFile
 bool CSV::Write(const std::string& fileName) {
-	if (waypoints.empty()) {
+	if (waypoints.Empty()) {
 		AirspaceConverter::LogMessage("CSV output: no waypoints, nothing to write");
 		return false;
 	}
@@ -491,13 +500,11 @@ bool CSV::Write(const std::string& fileName) {
 	//file << "Type,Name,Ident,Lat,Lon,Elev,Decl,Label,Desc,Country,Range,ModificationTime,SourceFile\r\n";
 
 	// Go trough all waypoints
-	for (const std::pair<const int,Waypoint*>& pair : waypoints) {
-		assert(pair.second != nullptr);
-		const Waypoint& w(*pair.second);
+	for (const WaypointStore::Entry w : waypoints) {
 
 		// Name is mandatory according to CSV specs
 		if (w.GetName().empty()) {
-			AirspaceConverter::LogWarning("skipping waypoint with long name empty: " + w.GetCode());
+			AirspaceConverter::LogWarning("skipping waypoint with long name empty: " + std::string(w.GetCode()));
 			continue;
 		}
 
@@ -576,18 +583,16 @@ bool CSV::Write(const std::string& fileName) {
 
 		// Label/Tag is composed by Dir:N Len:N Freq:N to avoid lost of information
 		if (w.IsAirfield()) {
-			const Airfield& a((const Airfield&)w);
-
 			// Runway direction, miss in CSV spec
-			if (a.HasRunwayDir()) file << "Dir:" << std::setfill('0') << std::setw(3) << a.GetRunwayDir() << " ";
+			if (w.HasRunwayDir()) file << "Dir:" << std::setfill('0') << std::setw(3) << w.GetRunwayDir() << " ";
 
 			// Runway length, miss in CSV spec
-			if (a.HasRunwayLength()) file << "Len:" << a.GetRunwayLength() << "m ";
+			if (w.HasRunwayLength()) file << "Len:" << w.GetRunwayLength() << "m ";
 
 			// Radio frequency, miss in CSV spec
-			if (a.HasRadioFrequency()) {
-				file << "Freq:" << std::setprecision(3) << AirspaceConverter::FrequencyMHz(a.GetRadioFrequency()); // 3 decimals for Airports freq [MHz]
-				if (a.HasOtherFrequency()) file << '-' << AirspaceConverter::FrequencyMHz(a.GetOtherFrequency());
+			if (w.HasRadioFrequency()) {
+				file << "Freq:" << std::setprecision(3) << AirspaceConverter::FrequencyMHz(w.GetRadioFrequency()); // 3 decimals for Airports freq [MHz]
+				if (w.HasOtherFrequency()) file << '-' << AirspaceConverter::FrequencyMHz(w.GetOtherFrequency());
 			}
 		} else {
 			// Other frequency
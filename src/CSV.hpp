@@ -16,11 +16,13 @@
 #include <map>
 
 class Waypoint;
+class WaypointStore;
+struct ConversionContext;
 
 class CSV {
 
 public:
-	CSV(std::multimap<int,Waypoint*>& waypointsMap);
+	CSV(WaypointStore& waypointsStore, const ConversionContext& conversionContext);
 	~CSV() {}
 	bool Read(const std::string& fileName);
 	bool Write(const std::string& fileName);
@@ -35,5 +37,6 @@ private:
 	static bool ParseAirfieldFrequencies(const std::string& text, int& mainFreqHz, int& secondaryFreqHz);
 	static bool ParseOtherFrequency(const std::string& text, const int type, int& freqHz);
 
-	std::multimap<int,Waypoint*>& waypoints;
+	WaypointStore& waypoints;
+	const ConversionContext& context;
 };
@@ -0,0 +1,119 @@
+//============================================================================
+// AirspaceConverter
+// Web         : https://www.alus.it/AirspaceConverter
+// Repository  : https://github.com/alus-it/AirspaceConverter.git
+// License     : GNU GPL v3
+//
+// This source file is part of AirspaceConverter project
+//============================================================================
+
+#include "ConversionContext.hpp"
+#include "AirspaceConverter.hpp"
+#include "RasterMap.hpp"
+#include "Airspace.hpp"
+#include <map>
+#include <cmath>
+#include <format>
+#include <cassert>
+
+bool TerrainMaps::Add(const std::string& filename) {
+	std::shared_ptr<RasterMap> terrainMap(std::make_shared<RasterMap>());
+	if (!terrainMap->Open(filename)) return false;
+	maps.push_back(terrainMap);
+	return true;
+}
+
+bool TerrainMaps::GetTerrainAltitudeMt(const double& lat, const double& lon, double& alt) const {
+	if (maps.empty()) return false; // no maps no party...
+	const RasterMap* bestMap = maps.front().get();
+	if (maps.size() > 1)
+	{
+		std::multimap<double, const RasterMap*> results; // preselected maps, minStepSize (kind of resolution) used as key
+		double minStepSize = 8000; // 8000 it's just a quite big number which I like
+		for (const std::shared_ptr<const RasterMap>& pTerreinMap : maps) {
+			if (pTerreinMap->PointIsInTerrainRange(lat, lon)) { // of course we want only maps covering our desired point!
+				double stepSize = pTerreinMap->GetStepSize();
+				if (stepSize < minStepSize) minStepSize = stepSize; // remember the best resolution
+				results.insert(std::pair<double, const RasterMap*>(stepSize, pTerreinMap.get())); // maps indexed on resolution
+			}
+		}
+		if (results.empty()) return false; // no results, the party is over ...
+		if (results.size() == 1) bestMap = results.begin()->second; // only one, so that's easy
+		else {
+			double minLatDiff = 90; // to find a latitude difference more than 90 degrees should be quite challenging...
+			const auto filtered = results.equal_range(minStepSize); // so now we have maps indexed on resolution and we even know the best resolution ...
+			for (auto it = filtered.first; it != filtered.second; ++it) { // look for the map with our point at higer absolute latitudes (samples more dense on earth surface)
+				double latDiff = lat >= 0 ? it->second->GetTop() - lat : lat - it->second->GetBottom();
+				assert(latDiff >= 0);
+				if (latDiff < minLatDiff) { // look for the minimum latitude difference with the proper N or S edge of the map
+					minLatDiff = latDiff;
+					bestMap = it->second;
+				}
+			}
+		}
+		assert(bestMap->PointIsInTerrainRange(lat, lon));
+	}
+	short altMt;
+	if (bestMap->GetTerrainHeight(lat, lon, altMt)) {
+		alt = altMt;
+		return true;
+	}
+	return false;
+}
+
+ConversionContext::ConversionContext() :
+	QNH(Altitude::QNE),
+	resolution(Geometry::DEFAULT_RESOLUTION),
+	defaultTerrainAltitudeMt(20),
+	terrainMaps(std::make_shared<const TerrainMaps>()),
+	calculateArcs(true),
+	arcsFittingToleranceMt(0),
+	openAirCoordinates(AUTO),
+	surfacesOnSphere(false),
+	clipOnLatLonLimits(false),
+	filterOnAltitude(false) {
+}
+
+bool ConversionContext::VerifyAltitudeOnTerrainMap(const double& lat, const double& lon, float& alt, const bool& blankAltitude, const bool& altitudeParsed, const int& line, const bool isSpike /*= false*/) const {
+	double terrainAlt;
+	if (terrainMaps->GetTerrainAltitudeMt(lat, lon, terrainAlt)) {
+		if (altitudeParsed) {
+			const double delta = isSpike ? alt - terrainAlt : fabs(alt - terrainAlt); // Spike such as an antenna, tower, VOR, etc: consider higher theresold in this case
+			if (isSpike ? delta > 100 || delta < 0 : terrainAlt > 5 ? delta > 10 : delta > 15) { // Consider bigger threshold if delta > 5 m (maybe it was really intended AMSL)
+				AirspaceConverter::LogWarning(std::format("on line {}: detected altitude difference of: {} m respect ground, using terrain altitude: {} m", line, delta, terrainAlt));
+				alt = (float)terrainAlt;
+			}
+		} else {
+			if (blankAltitude) AirspaceConverter::LogWarning(std::format("on line {}: blank elevation, using terrain altitude: {} m", line, terrainAlt));
+			else AirspaceConverter::LogWarning(std::format("on line {}: invalid elevation, using terrain altitude: {} m", line,terrainAlt));
+			alt = (float)terrainAlt;
+		}
+		return true;
+	} 
+	if (blankAltitude) AirspaceConverter::LogWarning(std::format("on line {}: blank elevation, waypoint out of loaded terrain maps: assuming AMSL", line));
+	else if (!altitudeParsed) AirspaceConverter::LogWarning(std::format("on line {}: invalid elevation, waypoint out of loaded terrain maps: assuming AMSL", line));
+	return false;
+}
+
+// The filters below must exclude only what AirspaceConverter::FilterOnAltitudeLimits() and FilterOnLatLonLimits() would remove anyway
+bool ConversionContext::IsExcludedOnAltitude(const Altitude& base, const Altitude& top) const {
+	return filterOnAltitude && !Airspace::IsWithinAltLimits(base, top, altitudeFloor, altitudeCeiling);
+}
+
+bool ConversionContext::IsExcludedOnPosition(const Geometry::Box& box) const {
+	return latLonLimits.IsValid() && box.IsOutsideLimits(latLonLimits);
+}
+
+bool ConversionContext::IsExcludedOnPosition(const Airspace& airspace) const {
+	if (!latLonLimits.IsValid()) return false;
+	if (!clipOnLatLonLimits) return !airspace.IsWithinLatLonLimits(latLonLimits);
+
+	return airspace.GetBoundingBox().IsOutsideLimits(latLonLimits); // The clipping may keep a part of it also if no point is within
+}
+
+bool ConversionContext::IsWaypointExcluded(const Geometry::LatLon& position, const float altitudeMt) const {
+	if (!latLonLimits.IsPositionWithinLimits(position)) return true;
+	if (!filterOnAltitude) return false;
+	const Altitude altWptMt(altitudeMt, true, true);
+	return !(altWptMt >= altitudeFloor && altWptMt <= altitudeCeiling);
+}
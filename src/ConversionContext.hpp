@@ -0,0 +1,62 @@
+//============================================================================
+// AirspaceConverter
+// Web         : https://www.alus.it/AirspaceConverter
+// Repository  : https://github.com/alus-it/AirspaceConverter.git
+// License     : GNU GPL v3
+//
+// This source file is part of AirspaceConverter project
+//============================================================================
+
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include "Geometry.hpp"
+#include "Altitude.hpp"
+
+class RasterMap;
+class Airspace;
+
+// Terrain raster maps, only read once loaded: so the same maps can be used at the same time by more converters
+class TerrainMaps {
+public:
+	TerrainMaps() {}
+	bool Add(const std::string& filename);
+	inline size_t Size() const { return maps.size(); }
+	inline bool Empty() const { return maps.empty(); }
+	bool GetTerrainAltitudeMt(const double& lat, const double& lon, double& alt) const;
+
+private:
+	std::vector<std::shared_ptr<const RasterMap>> maps; // Shared with the copies of this list
+};
+
+// Settings of one converter, given to its readers and writers so more converters with different settings can run at the same time
+struct ConversionContext {
+	enum CoordinateType { // How to write the coordinates in OpenAir
+		DEG_DECIMAL_MIN = 0,
+		DEG_MIN_SEC,
+		AUTO
+	};
+
+	ConversionContext();
+	bool VerifyAltitudeOnTerrainMap(const double& lat, const double& lon, float& alt, const bool& blankAltitude, const bool& altitudeParsed, const int& line, const bool isSpike = false) const;
+	bool IsExcludedOnAltitude(const Altitude& base, const Altitude& top) const; // If an airspace with these limits is excluded by the altitude filter
+	bool IsExcludedOnPosition(const Geometry::Box& box) const; // If an airspace with all its points in this box is excluded by the position filter
+	bool IsExcludedOnPosition(const Airspace& airspace) const; // Same but looking at the points of the airspace
+	bool IsWaypointExcluded(const Geometry::LatLon& position, const float altitudeMt) const; // If a waypoint here is excluded by one of the filters
+	inline bool IsExcludedCategory(const int category) const { return category < (int)excludedCategories.size() && excludedCategories[category]; }
+
+	double QNH; // [hPa] used to calculate the altitude of the flight levels
+	double resolution; // [rad] maximum distance between points when discretizing arcs and circles
+	double defaultTerrainAltitudeMt; // [m] where no terrain map is available
+	std::shared_ptr<const TerrainMaps> terrainMaps; // Never null, copied before adding maps if shared with other converters
+	bool calculateArcs; // If arcs and circles have to be found when writing OpenAir
+	double arcsFittingToleranceMt; // If set the arcs are found with least squares fitting within this tolerance
+	CoordinateType openAirCoordinates;
+	bool surfacesOnSphere; // If area and perimeter written in KML are calculated on the sphere
+	Geometry::Limits latLonLimits; // If valid the airspaces and waypoints outside are not even loaded
+	bool clipOnLatLonLimits; // If the airspaces across the limits will be clipped, so they can be excluded only on their bounding box
+	bool filterOnAltitude; // If the airspaces and waypoints not within the altitude limits below are not even loaded
+	Altitude altitudeFloor, altitudeCeiling;
+	std::vector<bool> excludedCategories; // Indexed by airspace type, the airspaces of these categories are not even loaded
+};
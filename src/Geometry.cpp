@@ -15,6 +15,11 @@
 #include "OpenAir.hpp"
 #include <cmath>
 #include <cassert>
+#include <functional>
+#include <algorithm>
+#include <set>
+#include <queue>
+#include <unordered_set>
 
 const int Geometry::LatLon::UNDEF_LAT = -91;
 const int Geometry::LatLon::UNDEF_LON = -181;
@@ -30,11 +35,45 @@ const double Geometry::RAD2NM = (180.0 * 60) / PI;
 const double Geometry::NM2M = 1852.0;
 const double Geometry::MI2M = 1609.344;
 const double Geometry::M2RAD = NM2RAD / NM2M;
+const double Geometry::EARTH_RADIUS_KM = 6371.0088; // IUGG mean radius, to get the areas on the sphere
+#ifdef COMPACT_COORDINATES
+const double Geometry::LatLon::UNITS_PER_DEG = 360000; // 1/100 arc second
+const double Geometry::LatLon::UNIT2RAD = PI / (180 * 360000.0);
+#endif
 
 const double Geometry::TOL = 2e-10;
 
-double Geometry::resolution = 0.3 * NM2RAD; // 0.3 NM = 555.6 m
+const double Geometry::DEFAULT_RESOLUTION = 0.3 * NM2RAD; // 0.3 NM = 555.6 m
+const double Circle::MINIMUM_RADIUS = NM2RAD * 0.012; // 0.012 NM = 22.224 m
 
+#ifdef COMPACT_COORDINATES
+void Geometry::LatLon::convertDec2DegMin(const Coordinate& units, int& deg, double& min) {
+	const Coordinate u = std::abs(units);
+	deg = u / 360000;
+	min = (u % 360000) / 6000.0;
+}
+
+void Geometry::LatLon::convertDec2DegMinSec(const Coordinate& units, int& deg, int& min, int& sec) {
+	const Coordinate u = ((std::abs(units) + 50) / 100) * 100; // Round to the nearest second, carries are so already done
+	deg = u / 360000;
+	min = (u % 360000) / 6000;
+	sec = (u % 6000) / 100;
+}
+
+bool Geometry::LatLon::autoConvertDec2DegMinSec(const Coordinate& units, int& deg, double& decimalMin, int& min, int& sec) {
+	const Coordinate u = std::abs(units);
+	deg = u / 360000;
+	decimalMin = (u % 360000) / 6000.0;
+	min = (u % 360000) / 6000;
+	const Coordinate hundredths = u % 100;
+	if (hundredths <= 5 || hundredths >= 50) { // 0.05 sec = 1.5433 m
+		convertDec2DegMinSec(units, deg, min, sec);
+		return true;
+	}
+	sec = (u % 6000) / 100;
+	return false;
+}
+#else
 void Geometry::LatLon::convertDec2DegMin(const double& dec, int& deg, double& min) {
 	const double decimal = std::fabs(dec);
 	deg = (int)std::floor(decimal);
@@ -79,10 +118,17 @@ bool Geometry::LatLon::autoConvertDec2DegMinSec(const double& dec, int& deg, dou
 	if (std::fabs(decimalMin) <= TOL) decimalMin = 0;
 	return false;
 }
+#endif
 
 bool Geometry::LatLon::IsAlmostEqual(const LatLon& other) const {
 	if (*this == other) return true;
-	return std::fabs(lat-other.lat) < DEGTOL && std::fabs(lon-other.lon) < DEGTOL;
+	return std::fabs(Lat()-other.Lat()) < DEGTOL && std::fabs(Lon()-other.Lon()) < DEGTOL;
+}
+
+size_t Geometry::LatLon::Hash::operator()(const LatLon& p) const {
+	// Zero is normalized so -0 and +0, which are equal, get the same hash
+	const size_t h = std::hash<Coordinate>()(p.lat == 0 ? 0 : p.lat);
+	return h ^ (std::hash<Coordinate>()(p.lon == 0 ? 0 : p.lon) + 0x9e3779b9 + (h << 6) + (h >> 2));
 }
 
 bool Geometry::Limits::Set(const LatLon& topLeftLimit, const LatLon& bottomRightLimit) {
@@ -116,7 +162,7 @@ bool Geometry::Limits::IsPositionWithinLimits(const LatLon& pos) const {
 	if (!valid) return true; // If no limit or not valid limit accept it
 	assert(pos.IsValid());
 	if (pos.Lat() > topLeft.Lat() || pos.Lat() < bottomRight.Lat()) return false;
-	if (acrossAntiGreenwich) return pos.Lon() >= 0 ? pos.Lon() <= topLeft.Lon() : pos.Lon() <= bottomRight.Lon();
+	if (acrossAntiGreenwich) return pos.Lon() >= topLeft.Lon() || pos.Lon() <= bottomRight.Lon();
 	else return pos.Lon() >= topLeft.Lon() && pos.Lon() <= bottomRight.Lon();
 }
 
@@ -124,10 +170,115 @@ bool Geometry::Limits::IsPositionWithinLimits(const double& lat, const double& l
 	if (!valid) return true; // If no limit or not valid limit accept it
 	assert(LatLon::IsValidLat(lat) && LatLon::IsValidLon(lon));
 	if (lat > topLeft.Lat() || lat < bottomRight.Lat()) return false;
-	if (acrossAntiGreenwich) return lon >= 0 ? lon <= topLeft.Lon() : lon <= bottomRight.Lon();
+	if (acrossAntiGreenwich) return lon >= topLeft.Lon() || lon <= bottomRight.Lon();
 	else return lon >= topLeft.Lon() && lon <= bottomRight.Lon();
 }
 
+void Geometry::Box::Add(const double bottomLat, const double topLat, const double leftLon, const double rightLon) {
+	if (bottomLat < minLat) minLat = bottomLat;
+	if (topLat > maxLat) maxLat = topLat;
+	if (leftLon < minLon) minLon = leftLon;
+	if (rightLon > maxLon) maxLon = rightLon;
+}
+
+bool Geometry::Box::IsWithinLimits(const Limits& limits) const {
+	if (IsEmpty()) return false;
+	if (!limits.IsValid()) return true;
+	if (minLat < limits.GetBottomLatitudeLimit() || maxLat > limits.GetTopLatitudeLimit()) return false;
+	if (IsAllLongitudes()) return limits.GetLeftLongitudeLimit() == -180 && limits.GetRightLongitudeLimit() == 180;
+	if (limits.IsAcrossAntiGreenwich()) return minLon >= limits.GetLeftLongitudeLimit() || maxLon <= limits.GetRightLongitudeLimit();
+	return minLon >= limits.GetLeftLongitudeLimit() && maxLon <= limits.GetRightLongitudeLimit();
+}
+
+bool Geometry::Box::IsOutsideLimits(const Limits& limits) const {
+	if (IsEmpty()) return true;
+	if (!limits.IsValid()) return false;
+	if (minLat > limits.GetTopLatitudeLimit() || maxLat < limits.GetBottomLatitudeLimit()) return true;
+	if (IsAllLongitudes()) return false;
+	if (limits.IsAcrossAntiGreenwich()) return minLon > limits.GetRightLongitudeLimit() && maxLon < limits.GetLeftLongitudeLimit();
+	return maxLon < limits.GetLeftLongitudeLimit() || minLon > limits.GetRightLongitudeLimit();
+}
+
+Geometry::RadianPoints::RadianPoints(const std::vector<LatLon>& sourcePoints) : points(sourcePoints) {
+	lats.reserve(points.size());
+	lons.reserve(points.size());
+	xs.reserve(points.size());
+	ys.reserve(points.size());
+	zs.reserve(points.size());
+	for (const LatLon& p : points) {
+		lats.push_back(p.LatRad());
+		lons.push_back(p.LonRad());
+		const double cosLat = cos(lats.back());
+		xs.push_back(cosLat * cos(lons.back()));
+		ys.push_back(cosLat * sin(lons.back()));
+		zs.push_back(sin(lats.back()));
+	}
+}
+
+Geometry::EdgeTable::EdgeTable(const std::vector<LatLon>& polygon) : minLat(90), maxLat(-90), minLon(0) {
+	if (polygon.size() < 4) return;
+
+	// Vertices with continuous longitudes, also across the antimeridian
+	std::vector<double> lats, lons;
+	lats.reserve(polygon.size() + 2);
+	lons.reserve(polygon.size() + 2);
+	lats.push_back(polygon.front().Lat());
+	lons.push_back(polygon.front().Lon());
+	for (size_t i = 1; i < polygon.size(); i++) {
+		lats.push_back(polygon[i].Lat());
+		lons.push_back(lons.back() + DeltaLonDeg(polygon[i - 1].Lon(), polygon[i].Lon()));
+	}
+
+	// If it goes around a pole close it passing from the pole: the nearest one to its mean latitude
+	if (std::fabs(lons.back() - lons.front()) > 180) {
+		double sumLat(0);
+		for (size_t i = 1; i < lats.size(); i++) sumLat += lats[i];
+		const double pole(sumLat >= 0 ? 90 : -90);
+		lats.push_back(pole);
+		lons.push_back(lons.back());
+		lats.push_back(pole);
+		lons.push_back(lons.front());
+		lats.push_back(lats.front());
+		lons.push_back(lons.front());
+	}
+
+	// Build the edges
+	const size_t n(lats.size() - 1);
+	lats0.resize(n);
+	lats1.resize(n);
+	lons0.resize(n);
+	slopes.resize(n);
+	minLon = lons.front();
+	for (size_t i = 0; i < n; i++) {
+		lats0[i] = lats[i];
+		lats1[i] = lats[i + 1];
+		lons0[i] = lons[i];
+		slopes[i] = lats[i + 1] != lats[i] ? (lons[i + 1] - lons[i]) / (lats[i + 1] - lats[i]) : 0;
+		minLat = std::min(minLat, lats[i]);
+		maxLat = std::max(maxLat, lats[i]);
+		minLon = std::min(minLon, lons[i]);
+	}
+}
+
+bool Geometry::EdgeTable::Contains(const double lat, const double lon) const {
+	if (lat < minLat || lat > maxLat) return false;
+
+	// Bring the longitude in the same turn of the edges
+	double x(std::fmod(lon - minLon, 360.0));
+	if (x < 0) x += 360;
+	x += minLon;
+
+	// Count the edges crossed by a ray going east: without branches so the compiler can vectorize it
+	const size_t n(lats0.size());
+	const double* const y0(lats0.data());
+	const double* const y1(lats1.data());
+	const double* const x0(lons0.data());
+	const double* const k(slopes.data());
+	double crossings(0); // Counted as double, exact anyway, because GCC can't vectorize the conversion from the double comparisons to integers
+	for (size_t i = 0; i < n; i++) crossings += (((y0[i] > lat) != (y1[i] > lat)) & (x < x0[i] + (lat - y0[i]) * k[i])) ? 1.0 : 0.0;
+	return ((size_t)crossings & 1) == 1;
+}
+
 double Geometry::AbsAngle(const double& angle) { //to put angle in the range between 0 and 2PI
 	assert(!std::isinf(angle) && !std::isnan(angle));
 	double absangle = std::fmod(angle, TWO_PI);
@@ -214,7 +365,7 @@ Geometry::LatLon Geometry::CalcRadialPoint(const double& lat1, const double& lon
 	return LatLon::CreateFromRadiants(lat,lon);
 }
 
-double Geometry::FindStep(const double& radius, const double& angle) {
+double Geometry::FindStep(const double& radius, const double& angle, const double& resolution) {
 	assert(angle >= 0 && angle <= TWO_PI);
 	assert(radius >= 0 && radius <= PI_2);
 	static const double smallRadius = NM2RAD * 3; // 3 NM, radius under it the number of points will be decreased
@@ -225,6 +376,20 @@ double Geometry::FindStep(const double& radius, const double& angle) {
 	return angle / steps;
 }
 
+// Add the box of the circle on the sphere, a bit larger to contain also the rounding of the discretized points
+void Geometry::AddCircleToBox(const double& latc, const double& lonc, const double& radius, Box& box) {
+	static const double margin = 1e-5; // [deg] more than the rounding of the compact coordinates
+	const double lat(latc * RAD2DEG), lon(-lonc * RAD2DEG), r(radius * RAD2DEG + margin);
+	const double bottomLat(std::max(lat - r, -90.0)), topLat(std::min(lat + r, 90.0));
+	if (std::fabs(latc) + radius >= PI_2) { // Around a pole
+		box.Add(bottomLat, topLat, -180, 180);
+		return;
+	}
+	const double deltaLon(std::asin(std::sin(radius) / std::cos(latc)) * RAD2DEG + margin);
+	if (lon - deltaLon < -180 || lon + deltaLon > 180) box.Add(bottomLat, topLat, -180, 180); // Across the antimeridian
+	else box.Add(bottomLat, topLat, lon - deltaLon, lon + deltaLon);
+}
+
 bool Geometry::CalcBisector(const double& latA, const double& lonA, const double& latB, const double& lonB, const double& latC, const double& lonC, double& bisector) {
 	const double crsBA = CalcGreatCircleCourse(latB, lonB, latA, lonA);
 	const double crsBC = CalcGreatCircleCourse(latB, lonB, latC, lonC);
@@ -275,25 +440,28 @@ bool Geometry::CalcRadialIntersection(const double& lat1, const double& lon1, co
 	return true;
 }
 
-bool Geometry::ArePointsOnArc(const LatLon& A, const LatLon& B, const LatLon& C, double& latc, double& lonc, double& radius, bool& clockwise) {
+bool Geometry::ArePointsOnArc(const RadianPoints& points, const size_t a, const size_t b, const size_t c, double& latc, double& lonc, double& radius, bool& clockwise) {
 	static const double maxDst = (5000 / NM2M) * NM2RAD; // Do not process segments longer than 5 Km
-	const double latA = A.LatRad(); //TODO: maybe avoid to recalculate always
-	const double lonA = A.LonRad();
-	const double latB = B.LatRad();
-	const double lonB = B.LonRad();
-	const double latC = C.LatRad();
-	const double lonC = C.LonRad();
+	static const double maxSquaredChord = std::pow(2 * sin(maxDst / 2), 2) * (1 + 1e-6); // Same limit as straight distance, with a margin for rounding errors
+
+	// Cheap check, without trigonometry, to skip the segments surely too long
+	if (points.SquaredChord(a, b) > maxSquaredChord || points.SquaredChord(b, c) > maxSquaredChord) return false;
+
+	const double latA = points.LatRad(a);
+	const double lonA = points.LonRad(a);
+	const double latB = points.LatRad(b);
+	const double lonB = points.LonRad(b);
 
 	// Check distances
-	const double dstAB = CalcAngularDist(latA, lonA, latB, lonB);
+	const double dstAB = CalcAngularDist(points, a, b);
 	if (dstAB > maxDst) return false;
-	const double dstBC = CalcAngularDist(latB, lonB, latC, lonC);
+	const double dstBC = CalcAngularDist(points, b, c);
 	if (dstBC > maxDst) return false;
 	
 	// Calculate courses
-	const double crsAB = CalcGreatCircleCourse(latA, lonA, latB, lonB, dstAB);
-	const double crsBA = CalcGreatCircleCourse(latB, lonB, latA, lonA, dstAB);
-	const double crsBC = CalcGreatCircleCourse(latB, lonB, latC, lonC, dstBC);
+	const double crsAB = CalcGreatCircleCourse(points, a, b, dstAB);
+	const double crsBA = CalcGreatCircleCourse(points, b, a, dstAB);
+	const double crsBC = CalcGreatCircleCourse(points, b, c, dstBC);
 	
 	// Calculate course difference between two segments
 	const double delta = DeltaAngle(crsBC, crsBA);
@@ -328,6 +496,81 @@ bool Geometry::ArePointsOnArc(const LatLon& A, const LatLon& B, const LatLon& C,
 	return diff < limit;
 }
 
+// Least squares fit (Kasa) of a circle on the points from start to end projected on the plane tangent to the sphere in the middle one, then verified on the sphere
+bool Geometry::FitArc(const RadianPoints& points, const size_t start, const size_t end, const double tolerance, LatLon& center, double& radius, double& sweep) {
+	assert(end > start + 1);
+	const double num = double(end - start + 1);
+
+	// Axes of the tangent plane: east and north unit vectors
+	const size_t ref = start + (end - start) / 2;
+	const double px = points.X(ref), py = points.Y(ref), pz = points.Z(ref);
+	const double horiz = std::sqrt(px * px + py * py);
+	if (horiz < 0.01) return false; // Too near to a pole
+	const double ex = -py / horiz, ey = px / horiz; // East has no vertical component
+	const double nx = -pz * ey, ny = pz * ex, nz = px * ey - py * ex; // North = P x East
+	auto x = [&](const size_t i) { return points.X(i) * ex + points.Y(i) * ey; };
+	auto y = [&](const size_t i) { return points.X(i) * nx + points.Y(i) * ny + points.Z(i) * nz; };
+
+	// Center of mass of the points on the local plane
+	double mx = 0, my = 0;
+	for (size_t i = start; i <= end; i++) {
+		mx += x(i);
+		my += y(i);
+	}
+	mx /= num;
+	my /= num;
+
+	// Moments of the coordinates relative to the center of mass
+	double suu = 0, svv = 0, suv = 0, suuu = 0, svvv = 0, suvv = 0, svuu = 0;
+	for (size_t i = start; i <= end; i++) {
+		const double u = x(i) - mx, v = y(i) - my;
+		const double uu = u * u, vv = v * v;
+		suu += uu;
+		svv += vv;
+		suv += u * v;
+		suuu += uu * u;
+		svvv += vv * v;
+		suvv += u * vv;
+		svuu += v * uu;
+	}
+	const double det = suu * svv - suv * suv;
+	if (det <= 0) return false; // Points aligned
+
+	// Center of the circle back on the sphere
+	const double a = mx + 0.5 * ((suuu + suvv) * svv - (svvv + svuu) * suv) / det;
+	const double b = my + 0.5 * ((svvv + svuu) * suu - (suuu + suvv) * suv) / det;
+	const double h = 1 - a * a - b * b;
+	if (!(h > 0)) return false; // Center too far
+	const double up = std::sqrt(h);
+	const double cx = px * up + ex * a + nx * b, cy = py * up + ey * a + ny * b, cz = pz * up + nz * b;
+	const double latc = asin(std::max(-1.0, std::min(1.0, cz)));
+	const double lonc = atan2(cy, cx);
+
+	// Radius as average distance from the center
+	radius = 0;
+	for (size_t i = start; i <= end; i++) radius += CalcAngularDist(latc, lonc, points.LatRad(i), points.LonRad(i));
+	radius /= num;
+	if (radius <= 0 || radius >= PI_2) return false;
+
+	// All the points must be within tolerance and always going around the center in the same direction
+	// also the sides between them, if longer than the ones of a circle discretized with the minimum of 8 points, must not be too far from it
+	sweep = 0;
+	double prevCrs = CalcGreatCircleCourse(latc, lonc, points.LatRad(start), points.LonRad(start));
+	for (size_t i = start; i <= end; i++) {
+		if (std::fabs(CalcAngularDist(latc, lonc, points.LatRad(i), points.LonRad(i)) - radius) > tolerance) return false;
+		if (i == start) continue;
+		const double crs = CalcGreatCircleCourse(latc, lonc, points.LatRad(i), points.LonRad(i));
+		const double delta = DeltaAngle(crs, prevCrs);
+		if (delta == 0 || (sweep != 0 && (delta > 0) != (sweep > 0))) return false;
+		if (std::fabs(delta) > PI / 4 && radius * (1 - cos(delta / 2)) > tolerance) return false;
+		sweep += delta;
+		prevCrs = crs;
+	}
+	if (std::fabs(sweep) > TWO_PI + TOL) return false; // More than a full turn
+	center = LatLon::CreateFromRadiants(latc, lonc);
+	return true;
+}
+
 Geometry::LatLon Geometry::AveragePoints(const std::vector<std::pair<const double, const double>>& centerPoints) {
 	assert(!centerPoints.empty());
 	double latc = 0;
@@ -344,12 +587,12 @@ Geometry::LatLon Geometry::AveragePoints(const std::vector<std::pair<const doubl
 	return LatLon::CreateFromRadiants(latc, lonc);
 }
 
-double Geometry::AverageRadius(const Geometry::LatLon& center, const std::vector<Geometry::LatLon*>& circlePoints) {
+double Geometry::AverageRadius(const Geometry::LatLon& center, const RadianPoints& points, const std::vector<size_t>& circlePoints) {
 	assert(!circlePoints.empty());
 	double latc = center.LatRad();
 	double lonc = center.LonRad();
 	double radius = 0;
-	for (const Geometry::LatLon* p : circlePoints) radius += CalcAngularDist(latc, lonc, p->LatRad(), p->LonRad());
+	for (const size_t i : circlePoints) radius += CalcAngularDist(latc, lonc, points.LatRad(i), points.LonRad(i));
 	return (radius / circlePoints.size()) * 1.000675456; // corrected average
 }
 
@@ -404,7 +647,257 @@ bool Geometry::CalcAirfieldPolygon(const double lat, const double lon, const int
 	return true;
 }
 
-bool Point::Discretize(std::vector<LatLon>& output) const {
+// Longitude difference in degrees, from lon1 to lon2, taking the shortest way also across the antimeridian
+double Geometry::DeltaLonDeg(const double lon1, const double lon2) {
+	double delta = lon2 - lon1;
+	if (delta > 180) delta -= 360;
+	else if (delta < -180) delta += 360;
+	return delta;
+}
+
+// True if going from A to B and then to C the path goes back on itself along the same line
+// Collinear if the end of the shorter side is within the tolerance of the points from the line of the longer one
+bool Geometry::IsSpike(const LatLon& A, const LatLon& B, const LatLon& C) {
+	const double ux = DeltaLonDeg(B.Lon(), A.Lon()), uy = A.Lat() - B.Lat();
+	const double vx = DeltaLonDeg(B.Lon(), C.Lon()), vy = C.Lat() - B.Lat();
+	const double longer = std::sqrt(std::max(ux * ux + uy * uy, vx * vx + vy * vy));
+	return std::fabs(ux * vy - uy * vx) <= LatLon::DEGTOL * longer && ux * vx + uy * vy > 0;
+}
+
+// Check, with a sweep line on the lat/lon plane (Shamos-Hoey), if some sides of the closed polygon touch or cross each other
+bool Geometry::IsSelfIntersecting(const std::vector<LatLon>& polygon) {
+	assert(polygon.size() > 3);
+	assert(polygon.front() == polygon.back());
+	const size_t n = polygon.size() - 1; // Number of sides
+
+	// Vertices repeated, not consecutive, are already a self intersection
+	std::unordered_set<LatLon, LatLon::Hash> vertices;
+	vertices.reserve(n);
+	for (size_t i = 0; i < n; i++) if (!vertices.insert(polygon[i]).second) return true;
+
+	// Two consecutive sides going back on the same line
+	for (size_t i = 0; i < n; i++) if (IsSpike(polygon[(i + n - 1) % n], polygon[i], polygon[i + 1])) return true;
+
+	// Make the longitudes continuous, also for polygons crossing the antimeridian
+	std::vector<double> x(n + 1), y(n + 1);
+	x[0] = polygon[0].Lon();
+	y[0] = polygon[0].Lat();
+	for (size_t i = 1; i <= n; i++) {
+		x[i] = x[i - 1] + DeltaLonDeg(polygon[i - 1].Lon(), polygon[i].Lon());
+		y[i] = polygon[i].Lat();
+	}
+	if (std::fabs(x[n] - x[0]) > 180) return false; // Polygon around a pole: it can't be checked on the plane
+	x[n] = x[0];
+
+	// Sides with the first point at the left (or bottom if vertical)
+	struct Side {
+		double x0, y0, x1, y1, slope;
+	};
+	std::vector<Side> sides(n);
+	for (size_t i = 0; i < n; i++) {
+		const bool forward = x[i] < x[i + 1] || (x[i] == x[i + 1] && y[i] < y[i + 1]);
+		Side& s = sides[i];
+		if (forward) {
+			s.x0 = x[i]; s.y0 = y[i]; s.x1 = x[i + 1]; s.y1 = y[i + 1];
+		} else {
+			s.x0 = x[i + 1]; s.y0 = y[i + 1]; s.x1 = x[i]; s.y1 = y[i];
+		}
+		s.slope = s.x1 > s.x0 ? (s.y1 - s.y0) / (s.x1 - s.x0) : HUGE_VAL;
+	}
+
+	// Events: start and end of each side, ordered by x then y, at the same point the ends come before the starts
+	std::vector<std::pair<size_t, bool>> events; // index of the side and true if start
+	events.reserve(2 * n);
+	for (size_t i = 0; i < n; i++) {
+		events.emplace_back(i, true);
+		events.emplace_back(i, false);
+	}
+	std::sort(events.begin(), events.end(), [&sides](const std::pair<size_t, bool>& a, const std::pair<size_t, bool>& b) {
+		const Side& sa = sides[a.first];
+		const Side& sb = sides[b.first];
+		const double xa = a.second ? sa.x0 : sa.x1, ya = a.second ? sa.y0 : sa.y1;
+		const double xb = b.second ? sb.x0 : sb.x1, yb = b.second ? sb.y0 : sb.y1;
+		if (xa != xb) return xa < xb;
+		if (ya != yb) return ya < yb;
+		return a.second != b.second ? !a.second : a.first < b.first;
+	});
+
+	// Sides crossed by the sweep line ordered by latitude
+	double sweepX = 0;
+	auto yAt = [&sides, &sweepX](const size_t i) {
+		const Side& s = sides[i];
+		return s.slope == HUGE_VAL ? s.y0 : s.y0 + (sweepX - s.x0) * s.slope;
+	};
+	auto below = [&sides, &yAt](const size_t a, const size_t b) {
+		if (a == b) return false;
+		const double ya = yAt(a), yb = yAt(b);
+		if (ya != yb) return ya < yb;
+		if (sides[a].slope != sides[b].slope) return sides[a].slope < sides[b].slope;
+		return a < b;
+	};
+	std::set<size_t, decltype(below)> status(below);
+	std::vector<std::set<size_t, decltype(below)>::iterator> positions(n, status.end());
+
+	// Check if two not consecutive sides have at least one point in common
+	auto intersect = [&sides, n](const size_t a, const size_t b) {
+		if ((a + 1) % n == b || (b + 1) % n == a) return false; // Consecutive sides share a vertex
+		const Side& s = sides[a];
+		const Side& t = sides[b];
+		auto orientation = [](const double ax, const double ay, const double bx, const double by, const double cx, const double cy) {
+			const double cross = (bx - ax) * (cy - ay) - (by - ay) * (cx - ax);
+			return cross > 0 ? 1 : (cross < 0 ? -1 : 0);
+		};
+		auto onSide = [](const Side& q, const double px, const double py) {
+			return px >= std::min(q.x0, q.x1) && px <= std::max(q.x0, q.x1) && py >= std::min(q.y0, q.y1) && py <= std::max(q.y0, q.y1);
+		};
+		const int o1 = orientation(s.x0, s.y0, s.x1, s.y1, t.x0, t.y0);
+		const int o2 = orientation(s.x0, s.y0, s.x1, s.y1, t.x1, t.y1);
+		const int o3 = orientation(t.x0, t.y0, t.x1, t.y1, s.x0, s.y0);
+		const int o4 = orientation(t.x0, t.y0, t.x1, t.y1, s.x1, s.y1);
+		if (o1 != o2 && o3 != o4) return true;
+		return (o1 == 0 && onSide(s, t.x0, t.y0)) || (o2 == 0 && onSide(s, t.x1, t.y1)) || (o3 == 0 && onSide(t, s.x0, s.y0)) || (o4 == 0 && onSide(t, s.x1, s.y1));
+	};
+
+	for (const std::pair<size_t, bool>& e : events) {
+		const size_t i = e.first;
+		if (e.second) { // Start of a side: check it against the sides just above and below
+			sweepX = sides[i].x0;
+			const auto it = status.insert(i).first;
+			positions[i] = it;
+			if (it != status.begin() && intersect(*std::prev(it), i)) return true;
+			if (std::next(it) != status.end() && intersect(*std::next(it), i)) return true;
+		} else { // End of a side: the sides above and below become adjacent
+			sweepX = sides[i].x1;
+			const auto it = positions[i];
+			if (it != status.begin() && std::next(it) != status.end() && intersect(*std::prev(it), *std::next(it))) return true;
+			status.erase(it);
+		}
+	}
+	return false;
+}
+
+// Remove the vertices where the polygon goes back on itself, return true if something was removed
+bool Geometry::RemoveSpikes(std::vector<LatLon>& polygon) {
+	assert(polygon.size() > 3);
+	assert(polygon.front() == polygon.back());
+	const size_t origSize = polygon.size();
+	std::vector<LatLon> result;
+	result.reserve(origSize);
+	for (size_t i = 0; i < origSize - 1; i++) {
+		result.push_back(polygon[i]);
+		while (result.size() >= 3 && IsSpike(result[result.size() - 3], result[result.size() - 2], result.back())) {
+			result.erase(result.end() - 2);
+			if (result[result.size() - 2] == result.back()) result.pop_back();
+		}
+	}
+
+	// Check also across the first point
+	bool removed = true;
+	while (removed && result.size() >= 3) {
+		removed = false;
+		if (IsSpike(result[result.size() - 2], result.back(), result.front()) || result.back() == result.front()) {
+			result.pop_back();
+			removed = true;
+		} else if (IsSpike(result.back(), result.front(), result[1])) {
+			result.erase(result.begin());
+			removed = true;
+		}
+	}
+	if (!result.empty()) result.push_back(result.front());
+	polygon.swap(result);
+	return polygon.size() != origSize;
+}
+
+// Angular distance of point p from the great circle segment going from a to b
+double Geometry::CalcDistanceFromSegment(const RadianPoints& points, const size_t a, const size_t b, const size_t p) {
+	const double dap = CalcAngularDist(points, a, p);
+	const double dab = CalcAngularDist(points, a, b);
+	if (dap == 0 || dab == 0) return dap;
+	const double crsDiff = CalcGreatCircleCourse(points.LatRad(a), points.LonRad(a), points.LatRad(p), points.LonRad(p)) - CalcGreatCircleCourse(points.LatRad(a), points.LonRad(a), points.LatRad(b), points.LonRad(b));
+	if (cos(crsDiff) <= 0) return dap; // The point is behind the start of the segment
+	const double xtd = asin(sin(dap) * sin(crsDiff)); // Cross track distance
+	const double atd = acos(std::min(1.0, cos(dap) / cos(xtd))); // Along track distance
+	return atd < dab ? std::fabs(xtd) : CalcAngularDist(points, b, p);
+}
+
+// Douglas-Peucker on the sphere refining first the segments with the biggest deviation, so it can stop either on the tolerance or on the max number of points
+bool Geometry::Simplify(std::vector<LatLon>& polygon, const double toleranceMt, const size_t maxPoints /*= 0*/) {
+	assert(polygon.size() > 3);
+	assert(polygon.front() == polygon.back());
+	const size_t n = polygon.size() - 1; // Number of vertices
+	if (n <= 3 || (maxPoints == 0 && toleranceMt <= 0)) return false;
+	const double tolerance = toleranceMt * M2RAD;
+	const RadianPoints radPoints(polygon);
+
+	// Segments still to be refined with their farthest point
+	struct Segment {
+		size_t first, last, farthest;
+		double dist;
+		bool operator<(const Segment& other) const { return dist < other.dist; }
+	};
+	std::priority_queue<Segment> segments;
+	auto addSegment = [&segments, &radPoints](const size_t first, const size_t last) {
+		Segment s { first, last, first, -1 };
+		for (size_t i = first + 1; i < last; i++) {
+			const double d = CalcDistanceFromSegment(radPoints, first, last, i);
+			if (d > s.dist) {
+				s.dist = d;
+				s.farthest = i;
+			}
+		}
+		if (s.farthest != first) segments.push(s);
+	};
+
+	// Start from the first vertex and the one farthest from it
+	size_t opposite = 1;
+	double maxDist = 0;
+	for (size_t i = 1; i < n; i++) {
+		const double d = CalcAngularDist(radPoints, 0, i);
+		if (d > maxDist) {
+			maxDist = d;
+			opposite = i;
+		}
+	}
+	std::vector<bool> kept(n + 1, false);
+	kept[0] = kept[opposite] = kept[n] = true;
+	size_t numOfKept = 2;
+	addSegment(0, opposite);
+	addSegment(opposite, n);
+
+	// Add the next farthest point
+	auto refine = [&]() {
+		const Segment s = segments.top();
+		segments.pop();
+		kept[s.farthest] = true;
+		numOfKept++;
+		addSegment(s.first, s.farthest);
+		addSegment(s.farthest, s.last);
+	};
+	while (!segments.empty() && (numOfKept < 3 || (segments.top().dist > tolerance && (maxPoints == 0 || numOfKept < maxPoints)))) refine();
+	if (numOfKept == n) return false;
+
+	auto collect = [&]() {
+		std::vector<LatLon> result;
+		result.reserve(numOfKept + 1);
+		for (size_t i = 0; i <= n; i++) if (kept[i]) result.push_back(polygon[i]);
+		return result;
+	};
+	std::vector<LatLon> result(collect());
+
+	// The simplified polygon must not intersect itself if the original was fine: in that case add back more points, but not beyond the max number
+	if (IsSelfIntersecting(result) && !IsSelfIntersecting(polygon)) {
+		auto canRefine = [&]() { return !segments.empty() && (maxPoints == 0 || numOfKept < maxPoints); };
+		do {
+			for (size_t toAdd = std::max<size_t>(numOfKept / 4, 1); toAdd > 0 && canRefine(); toAdd--) refine();
+			result = collect();
+		} while (canRefine() && IsSelfIntersecting(result));
+		if (numOfKept == n || IsSelfIntersecting(result)) return false;
+	}
+	polygon.swap(result);
+	return true;
+}
+
+bool Point::Discretize(std::vector<LatLon>& output, const double) const {
 	output.push_back(point); // Here it's easy :)
 	return true;
 }
@@ -444,16 +937,30 @@ Sector::Sector(const LatLon& center, const LatLon& pointStart, const LatLon& poi
 	angleEnd = CalcGreatCircleCourse(latc, lonc, lat2r, lon2r);
 }
 
-bool Sector::Discretize(std::vector<LatLon>& output) const {
+Sector::Sector(const LatLon& center, const RadianPoints& points, const size_t start, const size_t end, const bool isClockwise)
+	: Geometry(center)
+	, clockwise(isClockwise)
+	, latc(center.LatRad())
+	, lonc(center.LonRad())
+	, A(points.Point(start))
+	, B(points.Point(end)) {
+	radius = CalcAngularDist(latc, lonc, points.LatRad(start), points.LonRad(start));
+	assert(radius > 0 && radius < PI_2);
+	assert(std::fabs((radius * RAD2NM) - (CalcAngularDist(latc, lonc, points.LatRad(end), points.LonRad(end)) * RAD2NM)) < 0.2);
+	angleStart = CalcGreatCircleCourse(latc, lonc, points.LatRad(start), points.LonRad(start));
+	angleEnd = CalcGreatCircleCourse(latc, lonc, points.LatRad(end), points.LonRad(end));
+}
+
+bool Sector::Discretize(std::vector<LatLon>& output, const double resolution) const {
 	if (clockwise) {
 		double e = angleStart <= angleEnd ? angleEnd : angleEnd + TWO_PI;
-		const double step = FindStep(radius, AbsAngle(e - angleStart));
+		const double step = FindStep(radius, AbsAngle(e - angleStart), resolution);
 		assert(angleStart <= e);
 		for (double a = angleStart; a < e; a += step) output.push_back(CalcRadialPoint(latc, lonc, a, radius));
 		output.push_back(CalcRadialPoint(latc, lonc, e, radius)); // Add the exact last point
 	} else {
 		const double s = angleStart >= angleEnd ? angleStart : angleStart + TWO_PI;
-		const double step = FindStep(radius, AbsAngle(s - angleEnd));
+		const double step = FindStep(radius, AbsAngle(s - angleEnd), resolution);
 		assert(s >= angleEnd);
 		for (double a = s; a > angleEnd; a -= step) output.push_back(CalcRadialPoint(latc, lonc, a, radius));
 		output.push_back(CalcRadialPoint(latc, lonc, angleEnd, radius)); // Add the exact last point
@@ -461,6 +968,10 @@ bool Sector::Discretize(std::vector<LatLon>& output) const {
 	return true;
 }
 
+void Sector::AddToBox(Box& box) const {
+	AddCircleToBox(latc, lonc, radius, box); // The arc is part of its circle
+}
+
 void Sector::WriteOpenAirGeometry(OpenAir& openAir) const {
 	openAir.WriteSector(*this);
 }
@@ -473,24 +984,27 @@ Circle::Circle(const LatLon& center, const double& radiusNM)
 	assert(radius > 0 && radius < PI_2);
 }
 
-bool Circle::Discretize(std::vector<LatLon>& output) const {
-	static const double minimumRadius = NM2RAD * 0.012; // 0.012 NM = 22.224 m
-	if (radius > minimumRadius) {
-		const double step = FindStep(radius, TWO_PI);
+bool Circle::Discretize(std::vector<LatLon>& output, const double resolution) const {
+	if (radius > MINIMUM_RADIUS) {
+		const double step = FindStep(radius, TWO_PI, resolution);
 		for (double a = 0; a < TWO_PI; a += step) output.push_back(CalcRadialPoint(latc, lonc, a, radius));
 	} else {
 		const double step = PI_2;
-		for (double a = 0; a < TWO_PI; a += step) output.push_back(CalcRadialPoint(latc, lonc, a, minimumRadius));
+		for (double a = 0; a < TWO_PI; a += step) output.push_back(CalcRadialPoint(latc, lonc, a, MINIMUM_RADIUS));
 	}
 	return true;
 }
 
+void Circle::AddToBox(Box& box) const {
+	AddCircleToBox(latc, lonc, std::max(radius, MINIMUM_RADIUS), box);
+}
+
 void Circle::WriteOpenAirGeometry(OpenAir& openAir) const {
 	openAir.WriteCircle(*this);
 }
 
 /* Airway not supported yet
-bool AirwayPoint::Discretize(std::vector<LatLon>& output) const {
+bool AirwayPoint::Discretize(std::vector<LatLon>& output, const double resolution) const {
 	return false;
 }
 */
@@ -12,6 +12,11 @@
 
 #pragma once
 #include <vector>
+#include <cstddef>
+#ifdef COMPACT_COORDINATES
+#include <cstdint>
+#include <cmath>
+#endif
 
 class Airspace;
 class OpenAir;
@@ -23,18 +28,18 @@ friend class OpenAir;
 public:
 	class LatLon {
 	public:
-		LatLon() : lat(UNDEF_LAT), lon(UNDEF_LON) {}
-		LatLon(const double& latitude, const double& longitude) : lat(latitude), lon(longitude) {}
+		LatLon() : lat(FromDeg(UNDEF_LAT)), lon(FromDeg(UNDEF_LON)) {}
+		LatLon(const double& latitude, const double& longitude) : lat(FromDeg(latitude)), lon(FromDeg(longitude)) {}
 		inline static LatLon CreateFromRadiants(const double& latRad, const double& lonRad) { return LatLon(latRad * RAD2DEG, -lonRad * RAD2DEG); }
-		inline double Lat() const { return lat; }
-		inline double Lon() const { return lon; }
-		inline double LatRad() const { return lat * DEG2RAD; }
-		inline double LonRad() const { return -lon * DEG2RAD; }
-		inline void GetLatLon(double& latitude, double& longitude) const { latitude = lat; longitude = lon; }
-		inline void SetLatLon(const double& latitude, const double& longitude) { lat = latitude; lon = longitude; }
-		inline void SetLat(const double& latitude) { lat = latitude; }
-		inline void SetLon(const double& longitude) { lon = longitude; }
-		inline void SetLatLonRad(const double latRad, const double lonRad) { lat = latRad * RAD2DEG; lon = -lonRad * RAD2DEG; }
+		inline double Lat() const { return ToDeg(lat); }
+		inline double Lon() const { return ToDeg(lon); }
+		inline double LatRad() const { return ToRad(lat); }
+		inline double LonRad() const { return -ToRad(lon); }
+		inline void GetLatLon(double& latitude, double& longitude) const { latitude = ToDeg(lat); longitude = ToDeg(lon); }
+		inline void SetLatLon(const double& latitude, const double& longitude) { lat = FromDeg(latitude); lon = FromDeg(longitude); }
+		inline void SetLat(const double& latitude) { lat = FromDeg(latitude); }
+		inline void SetLon(const double& longitude) { lon = FromDeg(longitude); }
+		inline void SetLatLonRad(const double latRad, const double lonRad) { lat = FromDeg(latRad * RAD2DEG); lon = FromDeg(-lonRad * RAD2DEG); }
 		inline bool operator==(const LatLon& other) const { return other.lat == lat && other.lon == lon; }
 		inline bool operator!=(const LatLon& other) const { return other.lat != lat || other.lon != lon; }
 		inline void GetLatDegMin(int& deg, double& min) const { return convertDec2DegMin(lat, deg, min); }
@@ -45,19 +50,40 @@ public:
 		inline bool GetAutoLonDegMinSec(int& deg, double& decimalMin, int& min, int& sec) const { return autoConvertDec2DegMinSec(lon, deg, decimalMin, min, sec); }
 		inline char GetNorS() const { return lat > 0 ? 'N' : 'S'; }
 		inline char GetEorW() const { return lon > 0 ? 'E' : 'W'; }
-		inline bool IsValid() const { return IsValidLat(lat) &&  IsValidLon(lon); }
+		inline bool IsValid() const { return IsValidLat(Lat()) &&  IsValidLon(Lon()); }
 		inline static bool IsValidLat(const double& la) { return la >= -90 && la <= 90; }
 		inline static bool IsValidLon(const double& lo) { return lo >= -180 && lo <= 180; }
 		bool IsAlmostEqual(const LatLon& other) const;
 		static const int UNDEF_LAT, UNDEF_LON;
+		static const double DEGTOL; // [deg] within it the points are almost equal
+
+		// To use exactly equal points as key of hash containers
+		struct Hash {
+			size_t operator()(const LatLon& p) const;
+		};
 
 	private:
-		double lat, lon;
+#ifdef COMPACT_COORDINATES
+		typedef int32_t Coordinate; // [1/100 arc second] compact representation: 8 bytes per point
+		inline static double ToDeg(const Coordinate& c) { return c / UNITS_PER_DEG; }
+		inline static double ToRad(const Coordinate& c) { return c * UNIT2RAD; }
+		inline static Coordinate FromDeg(const double& deg) { return (Coordinate)std::lround(deg * UNITS_PER_DEG); }
+		static void convertDec2DegMin(const Coordinate& units, int& deg, double& min);
+		static void convertDec2DegMinSec(const Coordinate& units, int& deg, int& min, int& sec);
+		static bool autoConvertDec2DegMinSec(const Coordinate& units, int& deg, double& decimalMin, int& min, int& sec);
+		static const double UNITS_PER_DEG;
+		static const double UNIT2RAD;
+#else
+		typedef double Coordinate; // [deg]
+		inline static double ToDeg(const Coordinate& c) { return c; }
+		inline static double ToRad(const Coordinate& c) { return c * DEG2RAD; }
+		inline static Coordinate FromDeg(const double& deg) { return deg; }
 		static void convertDec2DegMin(const double& dec, int& deg, double& min);
 		static void convertDec2DegMinSec(const double& dec, int& deg, int& min, int& sec);
 		static bool autoConvertDec2DegMinSec(const double& dec, int& deg, double& decimalMin, int& min, int& sec);
+#endif
+		Coordinate lat, lon;
 		static const double SIXTY;
-		static const double DEGTOL;
 	};
 
 	class Limits {
@@ -74,6 +100,7 @@ public:
 		inline double GetBottomLatitudeLimit() const { return bottomRight.Lat(); }
 		inline double GetLeftLongitudeLimit() const { return topLeft.Lon(); }
 		inline double GetRightLongitudeLimit() const { return bottomRight.Lon(); }
+		inline bool IsAcrossAntiGreenwich() const { return acrossAntiGreenwich; }
 		inline void Disable() { valid = false; }
 		bool IsPositionWithinLimits(const LatLon& pos) const;
 		bool IsPositionWithinLimits(const double& lat, const double& lon) const;
@@ -86,43 +113,103 @@ public:
 		bool acrossAntiGreenwich;
 	};
 
+	// Bounding box on the lat/lon plane, the longitudes are not taken across the antimeridian: so a box wider than
+	// 180 degrees is considered with all the longitudes, as the borders of its points may go across the antimeridian
+	class Box {
+	public:
+		Box() : minLat(90), maxLat(-90), minLon(180), maxLon(-180) {}
+		inline void Add(const LatLon& p) { Add(p.Lat(), p.Lat(), p.Lon(), p.Lon()); }
+		void Add(const double bottomLat, const double topLat, const double leftLon, const double rightLon);
+		inline bool IsEmpty() const { return minLat > maxLat; }
+		bool IsWithinLimits(const Limits& limits) const; // True if all the box is within the limits
+		bool IsOutsideLimits(const Limits& limits) const; // True if no part of the box is within the limits
+		inline bool IsAllLongitudes() const { return maxLon - minLon > 180; }
+
+		double minLat, maxLat, minLon, maxLon; // [deg]
+	};
+
+	// Read only view of a sequence of points with their coordinates converted only once in radians and in unit vectors
+	class RadianPoints {
+	public:
+		explicit RadianPoints(const std::vector<LatLon>& sourcePoints);
+		inline size_t Size() const { return lats.size(); }
+		inline const LatLon& Point(const size_t i) const { return points[i]; }
+		inline double LatRad(const size_t i) const { return lats[i]; }
+		inline double LonRad(const size_t i) const { return lons[i]; }
+		inline double X(const size_t i) const { return xs[i]; }
+		inline double Y(const size_t i) const { return ys[i]; }
+		inline double Z(const size_t i) const { return zs[i]; }
+		inline double SquaredChord(const size_t i, const size_t j) const { // Squared straight distance between the two points on the unit sphere
+			const double dx = xs[i] - xs[j], dy = ys[i] - ys[j], dz = zs[i] - zs[j];
+			return dx * dx + dy * dy + dz * dz;
+		}
+
+	private:
+		const std::vector<LatLon>& points;
+		std::vector<double> lats, lons; // [rad]
+		std::vector<double> xs, ys, zs; // Unit vectors
+	};
+
+	// Edges of a closed polygon on the lat/lon plane, in SoA form with continuous longitudes, for fast point in polygon tests
+	class EdgeTable {
+	public:
+		explicit EdgeTable(const std::vector<LatLon>& polygon);
+		bool Contains(const double lat, const double lon) const;
+
+	private:
+		std::vector<double> lats0, lats1; // [deg] Start and end latitudes of each edge
+		std::vector<double> lons0; // [deg] Start longitudes of each edge
+		std::vector<double> slopes; // [deg/deg] Variation of longitude per degree of latitude along each edge
+		double minLat, maxLat, minLon; // [deg]
+	};
+
 	virtual ~Geometry() {}
-	virtual bool Discretize(std::vector<LatLon>& output) const = 0;
-	static inline void SetResolution(const double resolutionNM) { resolution = resolutionNM * NM2RAD; }
+	virtual bool Discretize(std::vector<LatLon>& output, const double resolution) const = 0; // Resolution [rad] is the maximum distance between points
+	virtual void AddToBox(Box& box) const { box.Add(point); } // Enlarge the box to contain all the points the geometry can be discretized into
 	static bool CalcAirfieldPolygon(const double lat, const double lon, const int length, const int dir, std::vector<LatLon>& polygon);
+	static bool IsSelfIntersecting(const std::vector<LatLon>& polygon);
+	static bool RemoveSpikes(std::vector<LatLon>& polygon);
+	static bool Simplify(std::vector<LatLon>& polygon, const double toleranceMt, const size_t maxPoints = 0);
 	inline const LatLon& GetCenterPoint() const { return point; }
 
 	static const double NM2M, MI2M;
+	static const double NM2RAD, RAD2NM;
+	static const double DEFAULT_RESOLUTION; // [rad]
 
 protected:
 	Geometry(const LatLon& center) : point(center) {}
 	const LatLon point;
-	static double resolution; // [rad] maximun distance between points when discretizing
 	static const double TWO_PI;
 	static const double PI_2;
 	static const double DEG2RAD;
 	static const double RAD2DEG;
-	static const double NM2RAD;
-	static const double RAD2NM;
 	static const double M2RAD;
+	static const double EARTH_RADIUS_KM; // [Km] mean radius
 
-	static double FindStep(const double& radius, const double& angle);
+	static double FindStep(const double& radius, const double& angle, const double& resolution);
+	static void AddCircleToBox(const double& latc, const double& lonc, const double& radius, Box& box);
 	static double DeltaAngle(const double angle, const double reference);
 	static double AbsAngle(const double& angle);
 	static double AnglePi2Pi(const double& angle);
 	static double CalcGreatCircleCourse(const double& lat1, const double& lon1, const double& lat2, const double& lon2, const double& d);
 	static double CalcGreatCircleCourse(const double& lat1, const double& lon1, const double& lat2, const double& lon2);
 	static double CalcAngularDist(const double& lat1, const double& lon1, const double& lat2, const double& lon2);
+	inline static double CalcAngularDist(const RadianPoints& p, const size_t i, const size_t j) { return CalcAngularDist(p.LatRad(i), p.LonRad(i), p.LatRad(j), p.LonRad(j)); }
+	inline static double CalcGreatCircleCourse(const RadianPoints& p, const size_t i, const size_t j, const double& d) { return CalcGreatCircleCourse(p.LatRad(i), p.LonRad(i), p.LatRad(j), p.LonRad(j), d); }
 	static void CalcRadialPoint(const double& lat1, const double& lon1, const double& dir, const double& dst, double& lat, double& lon);
 	static LatLon CalcRadialPoint(const double& lat1, const double& lon1, const double& dir, const double& dst);
 	static bool CalcBisector(const double& latA, const double& lonA, const double& latB, const double& lonB, const double& latC, const double& lonC, double& bisector);
 	static void CalcSphericalTriangle(const double& a, const double& beta, const double& gamma, double& alpha, double& b, double& c);
 	static bool CalcRadialIntersection(const double& lat1, const double& lon1, const double& lat2, const double& lon2, const double& crs13, const double& crs23, double& lat3, double& lon3, double& dst13, double& dst23);
-	static bool ArePointsOnArc(const LatLon& A, const LatLon& B, const LatLon& C, double& latc, double& lonc, double& radius, bool& clockwise);
+	static bool ArePointsOnArc(const RadianPoints& points, const size_t a, const size_t b, const size_t c, double& latc, double& lonc, double& radius, bool& clockwise);
 	static LatLon AveragePoints(const std::vector<std::pair<const double, const double>>& centerPoints);
-	static double AverageRadius(const Geometry::LatLon& center, const std::vector<LatLon*>& circlePoints);
+	static double AverageRadius(const Geometry::LatLon& center, const RadianPoints& points, const std::vector<size_t>& circlePoints);
 	static double RoundDistanceInNM(const double radiusRad);
 	static bool IsInt(const double& number, int& intVal);
+	static double DeltaLonDeg(const double lon1, const double lon2);
+	static bool IsSpike(const LatLon& A, const LatLon& B, const LatLon& C);
+	static double CalcDistanceFromSegment(const RadianPoints& points, const size_t a, const size_t b, const size_t p);
+	static bool FitArc(const RadianPoints& points, const size_t start, const size_t end, const double tolerance, LatLon& center, double& radius, double& sweep);
 
 private:
 	static const double PI;
@@ -137,7 +224,7 @@ friend class OpenAir;
 public:
 	Point(const LatLon& latlon) : Geometry(latlon) {}
 	Point(const double& lat, const double& lon) : Geometry(LatLon(lat,lon)) {}
-	bool Discretize(std::vector<LatLon>& output) const;
+	bool Discretize(std::vector<LatLon>& output, const double resolution) const;
 
 private:
 	void WriteOpenAirGeometry(OpenAir& openAir) const;
@@ -150,7 +237,9 @@ friend class OpenAir;
 public:
 	Sector(const LatLon& center, const double radiusNM, const double dir1, const double dir2, const bool isClockwise);
 	Sector(const LatLon& center, const LatLon& pointStart, const LatLon& pointEnd, const bool isClockwise);
-	bool Discretize(std::vector<LatLon>& output) const;
+	Sector(const LatLon& center, const RadianPoints& points, const size_t start, const size_t end, const bool isClockwise);
+	bool Discretize(std::vector<LatLon>& output, const double resolution) const;
+	void AddToBox(Box& box) const;
 	inline double GetRadiusNM() const { return RAD2NM * radius; }
 	inline bool IsClockwise() const { return clockwise; }
 	inline const LatLon& GetStartPoint() const { return A; }
@@ -174,7 +263,8 @@ friend class OpenAir;
 
 public:
 	Circle(const LatLon& center, const double& radiusNM);
-	bool Discretize(std::vector<LatLon>& output) const;
+	bool Discretize(std::vector<LatLon>& output, const double resolution) const;
+	void AddToBox(Box& box) const;
 	inline double GetRadiusNM() const { return RAD2NM * radius; }
 
 private:
@@ -183,6 +273,7 @@ private:
 
 	const double radius; // [rad]
 	const double latc, lonc; // [rad]
+	static const double MINIMUM_RADIUS; // [rad] smaller circles are discretized with this radius
 };
 
 /* Airway for now not supported
@@ -190,7 +281,7 @@ class AirwayPoint : public Geometry
 {
 public:
 	AirwayPoint(const double& lat, const double& lon, const double& widthNM) : Geometry(LatLon(lat, lon)), width(widthNM) {}
-	bool Discretize(std::vector<LatLon>& output) const;
+	bool Discretize(std::vector<LatLon>& output, const double resolution) const;
 
 private:
 	double width;
@@ -12,13 +12,17 @@
 
 #include "KML.hpp"
 #include "Airspace.hpp"
+#include "AirspaceStore.hpp"
 #include "AirspaceConverter.hpp"
 #include "Waypoint.hpp"
 #include "Airfield.hpp"
+#include "WaypointStore.hpp"
 #include "Geometry.hpp"
+#include "ConversionContext.hpp"
 #include <zip.h>
 #include <filesystem>
 #include <cmath>
+#include <utility>
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/property_tree/xml_parser.hpp>
 #include <boost/property_tree/ptree.hpp>
@@ -126,15 +130,16 @@ const std::string KML::DetectIconsPath() {
 	return "./icons/";
 }
 
-KML::KML(std::multimap<int, Airspace>& airspacesMap, std::multimap<int, Waypoint*>& waypointsMap):
+KML::KML(AirspaceStore& airspacesMap, WaypointStore& waypointsStore, const ConversionContext& conversionContext):
 		airspaces(airspacesMap),
-		waypoints(waypointsMap),
+		waypoints(waypointsStore),
+		context(conversionContext),
 		allAGLaltitudesCovered(true),
 		processLineString(false),
 		folderCategory(Airspace::Type::UNDEFINED) {
 }
 
-std::string KML::PrepareTagText(const std::string& text) {
+std::string KML::PrepareTagText(const std::string_view text) {
 	std::string preparedText;
 	preparedText.reserve((size_t)(text.size() * 1.1));
 	for (size_t pos = 0; pos != text.size(); ++pos) {
@@ -278,7 +283,7 @@ void KML::OpenPlacemark(const Airspace& airspace) {
 	std::string longName(name);
 	if (airspace.GetClass() != Airspace::UNDEFINED && (airspace.GetType() == Airspace::CTR || airspace.GetType() == Airspace::TMA)) longName.append(" - " + Airspace::CategoryName(airspace.GetClass()));
 	double area(0), perimeter(0);
-	airspace.CalculateSurface(area, perimeter);
+	airspace.CalculateSurface(area, perimeter, context.surfacesOnSphere);
 	outputFile << "<Placemark>\n"
 		<< "<name>" << name << "</name>\n"
 		<< "<styleUrl>#Style" << airspace.GetCategoryName() << "</styleUrl>\n"
@@ -291,7 +296,7 @@ void KML::OpenPlacemark(const Airspace& airspace) {
 		<< "<SimpleData name=\"Base\">" << airspace.GetBaseAltitude().ToString() << "</SimpleData>\n";
 	outputFile << std::fixed << std::setprecision(3);
 	for (size_t i=0; i<airspace.GetNumberOfRadioFrequencies(); i++) {
-		const std::pair<int, std::string>& f = airspace.GetRadioFrequencyAt(i);
+		const std::pair<int, InternedString>& f = airspace.GetRadioFrequencyAt(i);
 		outputFile << "<SimpleData name=\"Radio\">";
 		if (!f.second.empty()) outputFile << f.second << ": ";
 		outputFile << AirspaceConverter::FrequencyMHz(f.first) << "</SimpleData>\n";
@@ -304,38 +309,37 @@ void KML::OpenPlacemark(const Airspace& airspace) {
 	outputFile << std::defaultfloat;
 }
 
-void KML::OpenPlacemark(const Waypoint* waypoint) {
-	const bool isAirfield = waypoint->IsAirfield();
-	const int altMt = (int)std::round(waypoint->GetAltitude());
+void KML::OpenPlacemark(const WaypointStore::Entry& waypoint) {
+	const bool isAirfield = waypoint.IsAirfield();
+	const int altMt = (int)std::round(waypoint.GetAltitude());
 	const int altFt = (int)std::round(altMt / Altitude::FEET2METER);
 	outputFile << "<Placemark>\n"
-		<< "<name>" << PrepareTagText(waypoint->GetName()) << "</name>\n"
-		<< "<styleUrl>#Style" << waypoint->GetTypeName() << "</styleUrl>\n";
+		<< "<name>" << PrepareTagText(waypoint.GetName()) << "</name>\n"
+		<< "<styleUrl>#Style" << waypoint.GetTypeName() << "</styleUrl>\n";
 	outputFile << "<visibility>" << (isAirfield ? 1 : 0) << "</visibility>\n"
 		<< "<ExtendedData>\n"
 		<< "<SchemaData schemaUrl=\"#WaypointId\">\n"
-		<< "<SimpleData name=\"Name\">" << PrepareTagText(waypoint->GetName()) << "</SimpleData>\n"
-		<< "<SimpleData name=\"Type\">" << waypoint->GetTypeName() << "</SimpleData>\n"
-		<< "<SimpleData name=\"Code\">" << PrepareTagText(waypoint->GetCode()) << "</SimpleData>\n"
-		<< "<SimpleData name=\"Country\">" << waypoint->GetCountry() << "</SimpleData>\n"
+		<< "<SimpleData name=\"Name\">" << PrepareTagText(waypoint.GetName()) << "</SimpleData>\n"
+		<< "<SimpleData name=\"Type\">" << waypoint.GetTypeName() << "</SimpleData>\n"
+		<< "<SimpleData name=\"Code\">" << PrepareTagText(waypoint.GetCode()) << "</SimpleData>\n"
+		<< "<SimpleData name=\"Country\">" << waypoint.GetCountry() << "</SimpleData>\n"
 		<< "<SimpleData name=\"AltMt\">" << altMt << "</SimpleData>\n"
 		<< "<SimpleData name=\"AltFt\">" << altFt << "</SimpleData>\n";
 	outputFile << std::fixed << std::setprecision(3);
 	if(isAirfield) {
-		const Airfield* airfield = (const Airfield*)waypoint;
-		if (airfield->HasRunwayDir()) outputFile << "<SimpleData name=\"RwyDir\">" << airfield->GetRunwayDir() << "</SimpleData>\n";
-		if (airfield->HasRunwayLength()) outputFile << "<SimpleData name=\"RwyLen\">" << airfield->GetRunwayLength() << "</SimpleData>\n";
-		if (airfield->HasRadioFrequency()) outputFile << "<SimpleData name=\"Radio\">" << AirspaceConverter::FrequencyMHz(airfield->GetRadioFrequency()) << "</SimpleData>\n";
-		if (airfield->HasOtherFrequency()) outputFile << "<SimpleData name=\"Radio\">" << AirspaceConverter::FrequencyMHz(airfield->GetOtherFrequency()) << "</SimpleData>\n";
+		if (waypoint.HasRunwayDir()) outputFile << "<SimpleData name=\"RwyDir\">" << waypoint.GetRunwayDir() << "</SimpleData>\n";
+		if (waypoint.HasRunwayLength()) outputFile << "<SimpleData name=\"RwyLen\">" << waypoint.GetRunwayLength() << "</SimpleData>\n";
+		if (waypoint.HasRadioFrequency()) outputFile << "<SimpleData name=\"Radio\">" << AirspaceConverter::FrequencyMHz(waypoint.GetRadioFrequency()) << "</SimpleData>\n";
+		if (waypoint.HasOtherFrequency()) outputFile << "<SimpleData name=\"Radio\">" << AirspaceConverter::FrequencyMHz(waypoint.GetOtherFrequency()) << "</SimpleData>\n";
 	}
-	if (waypoint->HasOtherFrequency()) {
-		if (waypoint->GetType() == Waypoint::WaypointType::VOR)
-			outputFile << "<SimpleData name=\"VOR\">" << AirspaceConverter::FrequencyMHz(waypoint->GetOtherFrequency()) << "</SimpleData>\n";
-		else if (waypoint->GetType() == Waypoint::WaypointType::NDB)
-			outputFile << "<SimpleData name=\"NDB\">" << std::setprecision(1) << AirspaceConverter::FrequencykHz(waypoint->GetOtherFrequency()) << "</SimpleData>\n";
+	if (waypoint.HasOtherFrequency()) {
+		if (waypoint.GetType() == Waypoint::WaypointType::VOR)
+			outputFile << "<SimpleData name=\"VOR\">" << AirspaceConverter::FrequencyMHz(waypoint.GetOtherFrequency()) << "</SimpleData>\n";
+		else if (waypoint.GetType() == Waypoint::WaypointType::NDB)
+			outputFile << "<SimpleData name=\"NDB\">" << std::setprecision(1) << AirspaceConverter::FrequencykHz(waypoint.GetOtherFrequency()) << "</SimpleData>\n";
 	}
 	outputFile << std::defaultfloat;
-	outputFile << "<SimpleData name=\"Desc\">" << PrepareTagText(waypoint->GetDescription()) << "</SimpleData>\n"
+	outputFile << "<SimpleData name=\"Desc\">" << PrepareTagText(waypoint.GetDescription()) << "</SimpleData>\n"
 		<< "</SchemaData>\n"
 		<< "</ExtendedData>\n";
 }
@@ -422,8 +426,8 @@ void KML::WriteSideWalls(const Airspace& airspace, const std::vector<double>& al
 bool KML::Write(const std::string& filename) {
 	
 	// Verify presence of waypoints and airspaces
-	const bool airspacesPresent = !airspaces.empty();
-	const bool waypointsPresent = !waypoints.empty();
+	const bool airspacesPresent = !airspaces.Empty();
+	const bool waypointsPresent = !waypoints.Empty();
 	if((!airspacesPresent && !waypointsPresent) || filename.empty()) {
 		AirspaceConverter::LogMessage("KML output: no airspace and no waypoints, nothing to write");
 		return false;
@@ -469,7 +473,7 @@ bool KML::Write(const std::string& filename) {
 		for (int t = Waypoint::unknown; t < Waypoint::numOfWaypointTypes; t++) {
 
 			// First verify if there are waypoints of that kind
-			if (waypoints.count(t) == 0) continue;
+			if (waypoints.Count(t) == 0) continue;
 
 			const bool isAirfield = Waypoint::IsTypeAirfield((Waypoint::WaypointType)t);
 
@@ -479,9 +483,8 @@ bool KML::Write(const std::string& filename) {
 				"<visibility>" << (isAirfield ? 1 : 0) <<"</visibility>\n"
 				"<open>false</open>\n";
 			
-			const auto filtered = waypoints.equal_range(t);
-			for (auto it = filtered.first; it != filtered.second; ++it) {
-				const Waypoint* w = it->second;
+			for (const std::uint32_t i : waypoints.IndexesOfType(t)) {
+				const WaypointStore::Entry w(waypoints.At(i));
 
 				// Open placemark
 				OpenPlacemark(w);
@@ -494,19 +497,16 @@ bool KML::Write(const std::string& filename) {
 				// If it is an airfield draw an estimation of the runway perimeter
 				if (isAirfield) {
 					
-					// Get the airfield
-					const Airfield* a = (const Airfield*)w;
-					
 					// Get its rinway length and direction
-					const int leng = a->GetRunwayLength();
-					dir = a->GetRunwayDir();
+					const int leng = w.GetRunwayLength();
+					dir = w.GetRunwayDir();
 
 					// If they are valid...
 					if (leng > 0 && dir > 0) {
 
 						// Calculate the runway perimeter
 						std::vector<Geometry::LatLon> airfieldPerimeter;
-						if (Geometry::CalcAirfieldPolygon(a->GetLatitude(), a->GetLongitude(), leng, dir, airfieldPerimeter)) {
+						if (Geometry::CalcAirfieldPolygon(w.GetLatitude(), w.GetLongitude(), leng, dir, airfieldPerimeter)) {
 							
 							// Open a multigeometry with a polygon clamped onto the ground
 							outputFile << "<MultiGeometry>\n"
@@ -519,10 +519,10 @@ bool KML::Write(const std::string& filename) {
 							// Add the four points
 							outputFile << std::setprecision(6);
 							for (const Geometry::LatLon& p : airfieldPerimeter)
-								outputFile << p.Lon() << "," << p.Lat() << "," << a->GetAltitude() << "\n";
+								outputFile << p.Lon() << "," << p.Lat() << "," << w.GetAltitude() << "\n";
 							
 							// Close the perimeter re-adding the first point 
-							outputFile << airfieldPerimeter.front().Lon() << "," << airfieldPerimeter.front().Lat() << "," << a->GetAltitude() << "\n";
+							outputFile << airfieldPerimeter.front().Lon() << "," << airfieldPerimeter.front().Lat() << "," << w.GetAltitude() << "\n";
 
 							// Close the polygon
 							ClosePolygon();
@@ -537,7 +537,7 @@ bool KML::Write(const std::string& filename) {
 				outputFile << "<Point>\n"
 					<< "<extrude>0</extrude>\n"
 					<< "<altitudeMode>" << (t != Waypoint::normal ? "clampToGround" : "absolute") << "</altitudeMode>\n" // Except "normal" are all objects on the ground
-					<< "<coordinates>" << std::setprecision(6) << w->GetLongitude() << "," << w->GetLatitude() << "," << (int)std::round(w->GetAltitude()) << "</coordinates>\n"
+					<< "<coordinates>" << std::setprecision(6) << w.GetLongitude() << "," << w.GetLatitude() << "," << (int)std::round(w.GetAltitude()) << "</coordinates>\n"
 					<< "</Point>\n";
 
 				// If the perimeter was drawn the the multigeometry have to be closed
@@ -573,11 +573,18 @@ bool KML::Write(const std::string& filename) {
 				"<visibility>1</visibility>\n"
 				"<open>true</open>\n";
 
+		// Calculate in parallel area and perimeter of the airspaces, so they will be already available for each placemark
+		const bool surfacesOnSphere(context.surfacesOnSphere);
+		std::as_const(airspaces).ParallelForEach([surfacesOnSphere](const size_t, const Airspace& airspace) {
+			double area, perimeter;
+			airspace.CalculateSurface(area, perimeter, surfacesOnSphere);
+		});
+
 		// For each airspace category
 		for (int t = Airspace::CLASSA; t < Airspace::UNDEFINED; t++) {
 
 			// First verify if there are airspaces of that class
-			if (airspaces.count(t) == 0) continue;
+			if (airspaces.Count(t) == 0) continue;
 
 			// Prepare the folder
 			outputFile << "<Folder>\n"
@@ -585,10 +592,7 @@ bool KML::Write(const std::string& filename) {
 				"<visibility>" << (Airspace::CategoryVisibleByDefault((Airspace::Type)t) ? 1 : 0) <<"</visibility>\n"
 				"<open>false</open>\n";
 
-			const auto filtered = airspaces.equal_range(t);
-			for (auto it = filtered.first; it != filtered.second; ++it) {
-
-				const Airspace& a = it->second;
+			for (const Airspace& a : airspaces.Category(t)) {
 
 				assert(a.GetNumberOfPoints() > 3);
 				assert(a.GetFirstPoint()==a.GetLastPoint());
@@ -603,8 +607,8 @@ bool KML::Write(const std::string& filename) {
 					// Try to get terrein altitude then add the AGL altitude to get AMSL altitude
 					std::vector<double> amslAltitudesMt;
 					for (const Geometry::LatLon& p : a.GetPoints()) {
-						double terrainHeightMt = AirspaceConverter::GetDefaultTerrainAlt();
-						allAGLaltitudesCovered = AirspaceConverter::GetTerrainAltitudeMt(p.Lat(), p.Lon(), terrainHeightMt) && allAGLaltitudesCovered;
+						double terrainHeightMt = context.defaultTerrainAltitudeMt;
+						allAGLaltitudesCovered = context.terrainMaps->GetTerrainAltitudeMt(p.Lat(), p.Lon(), terrainHeightMt) && allAGLaltitudesCovered;
 						amslAltitudesMt.push_back(terrainHeightMt + altitudeAGLmt);
 					}
 
@@ -631,8 +635,8 @@ bool KML::Write(const std::string& filename) {
 						// Try to get terrein altitude then add the AGL altitude to get AMSL altitude
 						std::vector<double> amslAltitudesMt;
 						for (const Geometry::LatLon& p : a.GetPoints()) {
-							double terrainHeightMt = AirspaceConverter::GetDefaultTerrainAlt();
-							allAGLaltitudesCovered = AirspaceConverter::GetTerrainAltitudeMt(p.Lat(), p.Lon(), terrainHeightMt) && allAGLaltitudesCovered;
+							double terrainHeightMt = context.defaultTerrainAltitudeMt;
+							allAGLaltitudesCovered = context.terrainMaps->GetTerrainAltitudeMt(p.Lat(), p.Lon(), terrainHeightMt) && allAGLaltitudesCovered;
 							amslAltitudesMt.push_back(terrainHeightMt + altitudeAGLmt);
 						}
 
@@ -696,7 +700,7 @@ bool KML::Write(const std::string& filename) {
 	}
 
 	// If it is necessary to add also the icons
-	if (!waypoints.empty()) {
+	if (!waypoints.Empty()) {
 		for (int i = Waypoint::unknown; i < Waypoint::numOfWaypointTypes; i++) {
 			// Get the icon PNG filename and prepare the path in the ZIP and the path from current dir
 			const std::string iconPath = iconsPath + waypointIcons[i];
@@ -835,7 +839,8 @@ bool KML::ReadKMZ(const std::string& filename) {
 	if(extractedKmlFile.empty()) return false;
 
 	// So then ... let's try to read the KML file
-	bool retValue = ReadKML(extractedKmlFile);
+	sourceFile = std::make_shared<const std::string>(filename);
+	bool retValue = ParseKML(extractedKmlFile);
 
 	// Delete the, probably huge, KML file because it already compressed inside the KMZ
 	std::remove(extractedKmlFile.c_str());
@@ -1004,6 +1009,7 @@ bool KML::ProcessPlacemark(const boost::property_tree::ptree& placemark) {
 
 		// Build the new airspace
 		Airspace airspace(category);
+		airspace.SetArena(airspaces.GetArena());
 
 		// If present get and set the name
 		if (placemark.count("name") > 0) {
@@ -1022,8 +1028,8 @@ bool KML::ProcessPlacemark(const boost::property_tree::ptree& placemark) {
 				if (simpleData.first != "SimpleData") continue;
 				std::string str(simpleData.second.get_child("<xmlattr>").get<std::string>("name"));
 
-				if (str == "Upper_Limit" || str == "Top") topPresent = AirspaceConverter::ParseAltitude(simpleData.second.data(), true, airspace);
-				else if (str == "Lower_Limit" || str == "Base") basePresent = AirspaceConverter::ParseAltitude(simpleData.second.data(), false, airspace);
+				if (str == "Upper_Limit" || str == "Top") topPresent = AirspaceConverter::ParseAltitude(simpleData.second.data(), true, airspace, context.QNH);
+				else if (str == "Lower_Limit" || str == "Base") basePresent = AirspaceConverter::ParseAltitude(simpleData.second.data(), false, airspace, context.QNH);
 				else if (str == "NAM" || str == "name" || str == "Name") labelName = simpleData.second.data();
 				else if (str == "IDENT") ident = simpleData.second.data();
 				else if (str == "Category") {
@@ -1083,6 +1089,9 @@ bool KML::ProcessPlacemark(const boost::property_tree::ptree& placemark) {
 			if (airspace.GetType() == Airspace::Type::UNDEFINED) return false;
 		}
 
+		// Skip it if its category is not wanted
+		if (context.IsExcludedCategory(airspace.GetType())) return true;
+
 		// The name can be empty also after doing GuessClassFromName(), so make sure there is something there
 		if (airspace.GetName().empty()) airspace.SetName(airspace.GetLongCategoryName());
 
@@ -1196,7 +1205,11 @@ bool KML::ProcessPlacemark(const boost::property_tree::ptree& placemark) {
 		if (pointsFound) {
 			// Check if the altitudes make sense
 			if (airspace.GetType() != Airspace::Type::UNDEFINED && airspace.GetBaseAltitude() < airspace.GetTopAltitude()) {
-				airspaces.insert(std::pair<int, Airspace>(airspace.GetType(), std::move(airspace)));
+
+				// Skip it if it is going to be filtered out anyway
+				if (context.IsExcludedCategory(airspace.GetType()) || context.IsExcludedOnAltitude(airspace.GetBaseAltitude(), airspace.GetTopAltitude()) || context.IsExcludedOnPosition(airspace)) return true;
+				airspace.SetSource(sourceFile);
+				airspaces.Insert(std::move(airspace));
 				return true;
 			} else AirspaceConverter::LogWarning("skipping Placemark with invalid altitudes: " + airspace.GetName());
 		}
@@ -1206,6 +1219,11 @@ bool KML::ProcessPlacemark(const boost::property_tree::ptree& placemark) {
 }
 
 bool KML::ReadKML(const std::string& filename) {
+	sourceFile = std::make_shared<const std::string>(filename);
+	return ParseKML(filename);
+}
+
+bool KML::ParseKML(const std::string& filename) {
 	std::ifstream input(filename);
 	if (!input.is_open() || input.bad()) {
 		AirspaceConverter::LogError("Unable to open KML file: " + filename);
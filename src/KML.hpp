@@ -15,16 +15,20 @@
 #include <vector>
 #include <map>
 #include <fstream>
+#include <memory>
 #include <boost/property_tree/ptree_fwd.hpp>
+#include "WaypointStore.hpp"
 
 class Altitude;
 class Airspace;
+class AirspaceStore;
 class Waypoint;
 class Airfield;
+struct ConversionContext;
 
 class KML {
 public:
-	KML(std::multimap<int, Airspace>& airspacesMap, std::multimap<int, Waypoint*>& waypointsMap);
+	KML(AirspaceStore& airspacesMap, WaypointStore& waypointsStore, const ConversionContext& conversionContext);
 	bool Write(const std::string& filename);
 	inline bool WereAllAGLaltitudesCovered() const { return allAGLaltitudesCovered; }
 	inline void ProcessLineStrings(bool LineStringAsAirspaces = true) { processLineString = LineStringAsAirspaces; }
@@ -32,10 +36,10 @@ public:
 	bool ReadKML(const std::string& filename);
 
 private:
-	static std::string PrepareTagText(const std::string& text);
+	static std::string PrepareTagText(const std::string_view text);
 	void WriteHeader(const bool airspacePresent, const bool waypointsPresent);
 	void OpenPlacemark(const Airspace& airspace);
-	void OpenPlacemark(const Waypoint* waypoint);
+	void OpenPlacemark(const WaypointStore::Entry& waypoint);
 	void OpenPolygon(const bool extrude, const bool absolute);
 	void ClosePolygon();
 	void WriteSideWalls(const Airspace& airspace);
@@ -43,6 +47,7 @@ private:
 	void WriteBaseOrTop(const Airspace& airspace, const Altitude& alt, const bool extrudeToGround = false);
 	void WriteBaseOrTop(const Airspace& airspace, const std::vector<double>& altitudesAmsl, const bool extrudeToGround = false);
 
+	bool ParseKML(const std::string& filename);
 	bool ProcessFolder(const boost::property_tree::ptree& folder, const int upperCategory);
 	bool ProcessPlacemark(const boost::property_tree::ptree& placemark);
 	static bool ProcessPolygon(const boost::property_tree::ptree& polygon, Airspace& airspace, bool& isExtruded, Altitude& avgAltitude);
@@ -53,8 +58,10 @@ private:
 	static const std::string airfieldColors[];
 	static const std::string waypointIcons[];
 	static const std::string iconsPath;
-	std::multimap<int, Airspace>& airspaces;
-	std::multimap<int, Waypoint*>& waypoints;
+	AirspaceStore& airspaces;
+	WaypointStore& waypoints;
+	const ConversionContext& context;
+	std::shared_ptr<const std::string> sourceFile;
 	std::ofstream outputFile;
 	bool allAGLaltitudesCovered;
 	bool processLineString;
@@ -12,9 +12,12 @@
 
 #include "OpenAIP.hpp"
 #include "Airspace.hpp"
+#include "AirspaceStore.hpp"
 #include "AirspaceConverter.hpp"
 #include "Waypoint.hpp"
 #include "Airfield.hpp"
+#include "WaypointStore.hpp"
+#include "ConversionContext.hpp"
 #include <cmath>
 #include <fstream>
 #include <format>
@@ -24,12 +27,13 @@
 
 using boost::property_tree::ptree;
 
-OpenAIP::OpenAIP(std::multimap<int, Airspace>& airspacesMap, std::multimap<int,Waypoint*>& waypointsMap):
+OpenAIP::OpenAIP(AirspaceStore& airspacesMap, WaypointStore& waypointsStore, const ConversionContext& conversionContext):
 	airspaces(airspacesMap),
-	waypoints(waypointsMap) {
+	waypoints(waypointsStore),
+	context(conversionContext) {
 }
 
-bool OpenAIP::ParseAltitude(const ptree& node, Altitude& altitude) {
+bool OpenAIP::ParseAltitude(const ptree& node, Altitude& altitude) const {
 	try {
 		ptree alt = node.get_child("ALT");
 		std::string str = alt.get_child("<xmlattr>").get<std::string>("UNIT");
@@ -59,7 +63,7 @@ bool OpenAIP::ParseAltitude(const ptree& node, Altitude& altitude) {
 			case 'S': //STD Standard atmosphere
 				if (str.at(1) == 'T' && str.at(2) == 'D') {
 					if (!isFL) return false;
-					altitude.SetFlightLevel(value);
+					altitude.SetFlightLevel(value, context.QNH);
 					return true;
 				}
 				break;
@@ -98,6 +102,9 @@ bool OpenAIP::ReadAirspaces(const std::string& fileName) {
 			return false;
 		}
 
+		// All the airspaces read will refer to this file
+		const std::shared_ptr<const std::string> sourceFile(std::make_shared<const std::string>(fileName));
+
 		// for all children of AIRSPACES tag
 		for (ptree::value_type const& asp : root.get_child("AIRSPACES")) {
 			if (asp.first != "ASP") continue;
@@ -161,7 +168,9 @@ bool OpenAIP::ReadAirspaces(const std::string& fileName) {
 					AirspaceConverter::LogWarning("skipping ASP with unknown/undefined CATEGORY attribute: " + str);
 					continue;
 				}
+				if (context.IsExcludedCategory(type)) continue; // Not wanted
 				Airspace airspace(type);
+				airspace.SetArena(airspaces.GetArena());
 
 				// Airspace name
 				str = asp.second.get<std::string>("NAME");
@@ -188,6 +197,9 @@ bool OpenAIP::ReadAirspaces(const std::string& fileName) {
 				if (airspace.GetTopAltitude() <= airspace.GetBaseAltitude())
 					AirspaceConverter::LogWarning("detected airspace with top and base equal or inverted: " + airspace.GetName());
 
+				// Skip it if it is going to be filtered out anyway
+				if (context.IsExcludedOnAltitude(airspace.GetBaseAltitude(), airspace.GetTopAltitude())) continue;
+
 				//Geometry
 				node = asp.second.get_child("GEOMETRY");
 
@@ -233,20 +245,26 @@ bool OpenAIP::ReadAirspaces(const std::string& fileName) {
 				// The number of points must be at least 3+1 (plus the closing one)
 				assert(airspace.GetNumberOfPoints() > 3);
 
+				// Skip it if it is going to be filtered out anyway
+				if (context.IsExcludedOnPosition(airspace)) continue;
+
 				// Verify that the current airspace it not already existing in our collection (apparently this happens in in the same openAIP file)
 				bool found(false);
 
 				// Filter only on airspaces of the same type
-				const auto filtered = airspaces.equal_range(airspace.GetType());
-				for (auto it = filtered.first; it != filtered.second && !found; ++it) {
-					if (it->second == airspace) {
+				for (const Airspace& existing : airspaces.Category(airspace.GetType())) {
+					if (existing == airspace) {
 						found = true;
-						AirspaceConverter::LogWarning("Skipping existing airspace: " + airspace.GetName() + " already known as: " + it->second.GetName());
+						AirspaceConverter::LogWarning("Skipping existing airspace: " + airspace.GetName() + " already known as: " + existing.GetName());
+						break;
 					}
 				}
 
 				// If it is not already present in our collection add the new airspace
-				if (!found) airspaces.insert(std::pair<int, Airspace>(airspace.GetType(), std::move(airspace)));
+				if (!found) {
+					airspace.SetSource(sourceFile);
+					airspaces.Insert(std::move(airspace));
+				}
 
 			} // for each ASP
 			return true;
@@ -363,6 +381,7 @@ bool OpenAIP::ParseAirports(const ptree& airportsNode) {
 			// Geolocation
 			double lat, lon, alt;
 			if (!ParseGeolocation(airportNode, lat, lon, alt)) continue;
+			if (context.IsWaypointExcluded(Geometry::LatLon(lat, lon), (float)alt)) continue; // Going to be filtered out anyway
 
 			// Runways: take the longest one
 			int rwyDir(0), rwyLen(0);
@@ -438,9 +457,9 @@ bool OpenAIP::ParseAirports(const ptree& airportsNode) {
 			}
 
 			// Build and store the airfield
-			Airfield* airfield = new Airfield(longName, shortName, countryCode, lat, lon, (float)alt, style, rwyDir, rwyLen, freqHz, comments.str());
-			if (secondaryFreqHz != 0) airfield->SetOtherFrequency(secondaryFreqHz);
-			waypoints.insert(std::pair<int, Waypoint*>(style, (Waypoint*)airfield));
+			Airfield airfield(longName, shortName, countryCode, lat, lon, (float)alt, style, rwyDir, rwyLen, freqHz, comments.str());
+			if (secondaryFreqHz != 0) airfield.SetOtherFrequency(secondaryFreqHz);
+			waypoints.Add(airfield);
 		} catch(...) {
 			AirspaceConverter::LogError("Exception while reading openAIP airports: airfield skipped");
 		}
@@ -504,6 +523,7 @@ bool OpenAIP::ParseNavAids(const ptree& navAidsNode) {
 			// Geolocation
 			double lat, lon, alt;
 			if (!ParseGeolocation(navAidNode, lat, lon, alt)) continue;
+			if (context.IsWaypointExcluded(Geometry::LatLon(lat, lon), (float)alt)) continue; // Going to be filtered out anyway
 
 			//Radio frequency
 			int freqHz(0);
@@ -531,9 +551,9 @@ bool OpenAIP::ParseNavAids(const ptree& navAidsNode) {
 			}
 
 			// Build and store the waypoint
-			Waypoint* waypoint = new Waypoint(longName, shortName, countryCode, lat, lon, (float)alt, style, comments.str());
-			if (freqHz > 0) waypoint->SetOtherFrequency(freqHz);
-			waypoints.insert(std::pair<int, Waypoint*>(style, waypoint));
+			Waypoint waypoint(longName, shortName, countryCode, lat, lon, (float)alt, style, comments.str());
+			if (freqHz > 0) waypoint.SetOtherFrequency(freqHz);
+			waypoints.Add(waypoint);
 		} catch(...) {
 			AirspaceConverter::LogError("Exception while reading openAIP navaids: waypoint skipped");
 		}
@@ -16,19 +16,22 @@
 #include <boost/property_tree/ptree_fwd.hpp>
 
 class Airspace;
+class AirspaceStore;
 class Waypoint;
+class WaypointStore;
 class Altitude;
+struct ConversionContext;
 
 class OpenAIP {
 
 public:
-	OpenAIP(std::multimap<int, Airspace>& airspacesMap, std::multimap<int,Waypoint*>& waypointsMap);
+	OpenAIP(AirspaceStore& airspacesMap, WaypointStore& waypointsStore, const ConversionContext& conversionContext);
 	~OpenAIP() {}
 	bool ReadAirspaces(const std::string& fileName);
 	bool ReadWaypoints(const std::string& fileName);
 
 private:
-	static bool ParseAltitude(const boost::property_tree::ptree& node, Altitude& altitude);
+	bool ParseAltitude(const boost::property_tree::ptree& node, Altitude& altitude) const;
 	static bool ParseGeolocation(const boost::property_tree::ptree& parentNode, double &lat, double &lon, double &alt);
 	static bool ParseContent(const boost::property_tree::ptree& parentNode, const std::string& tagName, std::string& outputString);
 	static bool ParseAttribute(const boost::property_tree::ptree& node, const std::string& attributeName, std::string& outputString);
@@ -39,6 +42,7 @@ private:
 	bool ParseNavAids(const boost::property_tree::ptree& navAidsNode);
 	//bool ParseHotSpots(const boost::property_tree::ptree& hotSpotsNode);
 
-	std::multimap<int,Airspace>& airspaces;
-	std::multimap<int,Waypoint*>& waypoints;
+	AirspaceStore& airspaces;
+	WaypointStore& waypoints;
+	const ConversionContext& context;
 };
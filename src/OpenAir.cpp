@@ -12,6 +12,7 @@
 
 #include "OpenAir.hpp"
 #include "AirspaceConverter.hpp"
+#include "AirspaceStore.hpp"
 #include <iomanip>
 #include <format>
 #include <boost/algorithm/string.hpp>
@@ -81,14 +82,16 @@ const std::unordered_map<std::string, Airspace::Type> OpenAir::openAirAirspaceTa
 	{ "UNKNOWN", Airspace::UNKNOWN }
 };
 
-bool OpenAir::calculateArcs = true;
-bool OpenAir::lastPointWasEqualToFirst = false;
-OpenAir::CoordinateType OpenAir::coordinateType = OpenAir::CoordinateType::AUTO;
-int OpenAir::linecount = 0;
 
-OpenAir::OpenAir(std::multimap<int, Airspace>& airspacesMap):
+OpenAir::OpenAir(AirspaceStore& airspacesMap, const ConversionContext& conversionContext):
 	airspaces(airspacesMap),
+	context(conversionContext),
+	lastPointWasEqualToFirst(false),
+	linecount(0),
 	varRotationClockwise(true),
+	firstPendingGeometry(0),
+	baseFound(false),
+	topFound(false),
 	lastACline(-1),
 	lastPointWasDDMMSS(false),
 	lastLatD(Geometry::LatLon::UNDEF_LAT),
@@ -96,7 +99,9 @@ OpenAir::OpenAir(std::multimap<int, Airspace>& airspacesMap):
 	lastLatS(0),
 	lastLonD(Geometry::LatLon::UNDEF_LON),
 	lastLonM(0),
-	lastLonS(0) {
+	lastLonS(0),
+	lastNorS(' '),
+	lastEorW(' ') {
 }
 
 std::string& OpenAir::RemoveComments(std::string &s) {
@@ -127,7 +132,7 @@ bool OpenAir::RemoveNonPrintable([[maybe_unused]]std::string &s) {
 	return nonPrintableFound;
 }
 
-bool OpenAir::ParseDegrees(const std::string& dddmmss, double& deg, bool isLon) {
+bool OpenAir::ParseDegrees(const std::string& dddmmss, double& deg, bool isLon) const {
 	// The OpenAir coordinate string can't be empty
 	if(dddmmss.empty()) return false;
 
@@ -192,7 +197,7 @@ bool OpenAir::ParseDegrees(const std::string& dddmmss, double& deg, bool isLon)
 	return true;
 }
 
-bool OpenAir::ParseCoordinates(const std::string& text, Geometry::LatLon& point) {
+bool OpenAir::ParseCoordinates(const std::string& text, Geometry::LatLon& point) const {
 	// Tokenize on spaces
 	boost::tokenizer<boost::char_separator<char> > tokens(text, boost::char_separator<char>(" "));
 	if(std::distance(tokens.begin(),tokens.end()) < 2) return false; // We expect at least 2 fields
@@ -276,9 +281,11 @@ bool OpenAir::Read(const std::string& fileName) {
 	std::setlocale(LC_ALL, "en_US.utf8");
 
 	linecount = 0;
+	sourceFile = std::make_shared<const std::string>(fileName);
 	std::string sLine;
 	bool allParsedOK = true, needToDetectCRLF = true, initialCRLF = false, isCRLF = false, lineEndingConsistent = true;
 	Airspace airspace;
+	airspace.SetArena(airspaces.GetArena());
 	while (!input.eof() && input.good()) {
 
 		// Get the line
@@ -411,13 +418,15 @@ bool OpenAir::Read(const std::string& fileName) {
 bool OpenAir::ParseAC(const std::string & line, Airspace& airspace) {
 	varRotationClockwise = true; // Reset var to default at beginning of new airspace segment
 	InsertAirspace(airspace); // If new airspace first store the actual one
+	firstPendingGeometry = 0;
+	baseFound = topFound = false;
 	assert(airspace.GetType() == Airspace::UNDEFINED);
 	Airspace::Type type = Airspace::UNDEFINED;
 	if (line.size() < 4 || line.at(2) !=' ') return false;
 	auto it = openAirAirspaceTable.find(line.substr(3));
 	if (it != openAirAirspaceTable.end()) type = it->second;
 	if (type == Airspace::UNDEFINED) return false;
-	airspace.SetType(type);
+	if (!context.IsExcludedCategory(type)) airspace.SetType(type); // Otherwise it stays undefined, so the rest of the airspace is skipped
 	return true;
 }
 
@@ -465,7 +474,12 @@ bool OpenAir::ParseAltitude(const std::string& line, const bool isTop, Airspace&
 	if (airspace.GetType() == Airspace::UNDEFINED) return true;
 	const std::string::size_type l = line.length();
 	if (l < 4) return false;
-	return AirspaceConverter::ParseAltitude(line.substr(3,l-3), isTop, airspace);
+	if (!AirspaceConverter::ParseAltitude(line.substr(3,l-3), isTop, airspace, context.QNH)) return false;
+	(isTop ? topFound : baseFound) = true;
+
+	// If it is going to be filtered out anyway skip the rest of the airspace
+	if (baseFound && topFound && context.IsExcludedOnAltitude(airspace.GetBaseAltitude(), airspace.GetTopAltitude())) airspace.SetType(Airspace::UNDEFINED);
+	return true;
 }
 
 bool OpenAir::ParseS(const std::string & line) {
@@ -483,9 +497,14 @@ bool OpenAir::ParseDP(const std::string& line, Airspace& airspace, const int& li
 	if (line.length() < 14) return false;
 	Geometry::LatLon point;
 	if (ParseCoordinates(line.substr(3), point)) {
+
+		// The points of the arcs and circles before must come first
+		DiscretizePendingGeometries(airspace);
+		const bool pointAdded(airspace.AddPoint(point));
+		firstPendingGeometry = airspace.GetNumberOfGeometries();
 	
 		// If adding the point did not succeed because it's a duplicate...
-		if (!airspace.AddPoint(point)) {
+		if (!pointAdded) {
 
 			// If the last point was not yet detected as equal to the first
 			if (!lastPointWasEqualToFirst) {
@@ -558,7 +577,7 @@ bool OpenAir::ParseDA(const std::string& line, Airspace& airspace, const int& li
 		double angleStart = std::stod(*(++token));
 		double angleEnd = std::stod(*(++token));
 		if (!CheckAngleDeg(angleStart) || !CheckAngleDeg(angleEnd)) AirspaceConverter::LogWarning(std::format("angle not in range 0-360 on line {}: {}", linenumber, line));
-		airspace.AddGeometry(new Sector(varPoint, radius, angleStart, angleEnd, varRotationClockwise));
+		airspace.AddGeometryOnly<Sector>(varPoint, radius, angleStart, angleEnd, varRotationClockwise);
 	} catch (...) {
 		return false;
 	}
@@ -576,7 +595,7 @@ bool OpenAir::ParseDB(const std::string& line, Airspace& airspace) {
 	if (!ParseCoordinates(*token, p1)) return false;
 	Geometry::LatLon p2;
 	if (!ParseCoordinates(*(++token), p2)) return false;
-	airspace.AddGeometry(new Sector(varPoint, p1, p2, varRotationClockwise));
+	airspace.AddGeometryOnly<Sector>(varPoint, p1, p2, varRotationClockwise);
 	return true;
 }
 
@@ -584,13 +603,18 @@ bool OpenAir::ParseDC(const std::string& line, Airspace& airspace) {
 	if (airspace.GetType() == Airspace::UNDEFINED) return true;
 	if (varPoint.Lat() == Geometry::LatLon::UNDEF_LAT || line.length() < 4) return false;
 	try {
-		airspace.AddGeometry(new Circle(varPoint, std::stod(line.substr(3))));
+		airspace.AddGeometryOnly<Circle>(varPoint, std::stod(line.substr(3)));
 	} catch (...) {
 		return false;
 	}
 	return true;
 }
 
+void OpenAir::DiscretizePendingGeometries(Airspace& airspace) {
+	airspace.DiscretizeGeometries(firstPendingGeometry, context.resolution);
+	firstPendingGeometry = airspace.GetNumberOfGeometries();
+}
+
 bool OpenAir::InsertAirspace(Airspace& airspace) {
 	if (airspace.GetType() == Airspace::UNDEFINED || airspace.GetName().empty()) {
 		airspace.Clear();
@@ -598,6 +622,19 @@ bool OpenAir::InsertAirspace(Airspace& airspace) {
 		return false;
 	}
 
+	// If it is going to be filtered out anyway skip it already on the bounding box, before discretizing its arcs and circles
+	if (context.latLonLimits.IsValid()) {
+		Geometry::Box box;
+		for (const Geometry::LatLon& p : airspace.GetPoints()) box.Add(p);
+		for (size_t i = firstPendingGeometry; i < airspace.GetNumberOfGeometries(); i++) airspace.GetGeometryAt(i)->AddToBox(box);
+		if (!box.IsAllLongitudes() && context.IsExcludedOnPosition(box)) { // Over all the longitudes it may go around a pole: its box would extend to it, known only once discretized
+			airspace.Clear();
+			lastPointWasEqualToFirst = false;
+			return false;
+		}
+	}
+	DiscretizePendingGeometries(airspace);
+
 	// Verify if is valid airspace giving a proper explanatory error message
 	bool validAirspace(airspace.GetNumberOfGeometries() > 0);
 
@@ -623,13 +660,17 @@ bool OpenAir::InsertAirspace(Airspace& airspace) {
 		validAirspace = false;
 	}
 
+	// Skip it also if no point is within the position filter
+	if (validAirspace && context.IsExcludedOnPosition(airspace)) validAirspace = false;
+
 	// If all OK insert the new airspace
 	if (validAirspace) {
 
 		// This should be just a warning
 		if (airspace.GetName().empty()) AirspaceConverter::LogWarning(std::format("at line {}: airspace without name.", lastACline));
 		
-		airspaces.insert(std::pair<int, Airspace>(airspace.GetType(), std::move(airspace)));
+		airspace.SetSource(sourceFile, lastACline);
+		airspaces.Insert(std::move(airspace));
 	}
 
 	// Otherwise discard it
@@ -639,7 +680,7 @@ bool OpenAir::InsertAirspace(Airspace& airspace) {
 }
 
 bool OpenAir::Write(const std::string& fileName) {
-	if (airspaces.empty()) {
+	if (airspaces.Empty()) {
 		AirspaceConverter::LogMessage("OpenAir output: no airspace, nothing to write");
 		return false;
 	}
@@ -653,11 +694,15 @@ bool OpenAir::Write(const std::string& fileName) {
 
 	WriteHeader();
 
+	// Calculate in parallel the geometries of all airspaces without them, so the writing below is only formatting
+	const double arcsFittingToleranceMt(context.arcsFittingToleranceMt);
+	if (context.calculateArcs) airspaces.ParallelForEach([arcsFittingToleranceMt](const size_t, Airspace& airspace) {
+		if (airspace.GetNumberOfGeometries() == 0) airspace.Undiscretize(arcsFittingToleranceMt);
+	});
+
 	// Go trough all airspace
-	for (std::pair<const int,Airspace>& pair : airspaces)
+	for (Airspace& a : airspaces)
 	{
-		// Get the airspace
-		Airspace& a = pair.second;
 
 		// Just a couple if assertions
 		assert(a.GetNumberOfPoints() > 3);
@@ -680,7 +725,7 @@ bool OpenAir::Write(const std::string& fileName) {
 		if (a.GetNumberOfRadioFrequencies() > 0) {
 			file << std::fixed << std::setprecision(3);
 			for (size_t i=0; i<a.GetNumberOfRadioFrequencies(); i++) {
-				const std::pair<int, std::string>& f = a.GetRadioFrequencyAt(i);
+				const std::pair<int, InternedString>& f = a.GetRadioFrequencyAt(i);
 				file << "AF " << AirspaceConverter::FrequencyMHz(f.first);
 				if (!f.second.empty()) file << ' ' << f.second;
 				file << "\n";
@@ -695,14 +740,14 @@ bool OpenAir::Write(const std::string& fileName) {
 		file << std::setfill('0');
 
 		// Write the geometries
-		if (calculateArcs) {
+		if (context.calculateArcs) {
 
 			// Get number of geometries
 			size_t numOfGeometries = a.GetNumberOfGeometries();
 
-			// If no geometries are defined we have to calculate them
+			// If no geometries are defined we have to calculate them (should be already done above)
 			if (numOfGeometries == 0) {
-				a.Undiscretize();
+				a.Undiscretize(arcsFittingToleranceMt);
 				numOfGeometries = a.GetNumberOfGeometries();
 			}
 			assert(numOfGeometries > 0);
@@ -767,7 +812,7 @@ void OpenAir::WriteLatLonDDMMmmm(const int& latD, const double& latM, const char
 
 void OpenAir::WritePoint(const Geometry::LatLon& point, bool isCenterPoint /* = false */, bool addPrefix /*= true*/) {
 	if (isCenterPoint && addPrefix) file << "V X=";
-	switch (coordinateType) {
+	switch (context.openAirCoordinates) {
 		case CoordinateType::DEG_DECIMAL_MIN: {
 			if (!isCenterPoint && addPrefix) file << "DP ";
 			int latD, lonD;
@@ -782,7 +827,7 @@ void OpenAir::WritePoint(const Geometry::LatLon& point, bool isCenterPoint /* =
 			point.GetLatDegMinSec(latD, latM, latS);
 			point.GetLonDegMinSec(lonD, lonM, lonS);
 			if (!isCenterPoint) {
-				if (lastPointWasDDMMSS && latD == lastLatD && latM == lastLatM && latS == lastLatS && lonD == lastLonD && lonM == lastLonM && lonS == lastLonS) return;
+				if (lastPointWasDDMMSS && latD == lastLatD && latM == lastLatM && latS == lastLatS && point.GetNorS() == lastNorS && lonD == lastLonD && lonM == lastLonM && lonS == lastLonS && point.GetEorW() == lastEorW) return;
 				lastPointWasDDMMSS = true;
 				lastLatD = latD;
 				lastLatM = latM;
@@ -790,6 +835,8 @@ void OpenAir::WritePoint(const Geometry::LatLon& point, bool isCenterPoint /* =
 				lastLonD = lonD;
 				lastLonM = lonM;
 				lastLonS = lonS;
+				lastNorS = point.GetNorS();
+				lastEorW = point.GetEorW();
 			}
 			if (!isCenterPoint && addPrefix) file << "DP ";
 			WriteLatLonDDMMSS(latD, latM, latS, point.GetNorS(), lonD, lonM, lonS, point.GetEorW());
@@ -803,7 +850,7 @@ void OpenAir::WritePoint(const Geometry::LatLon& point, bool isCenterPoint /* =
 			const bool lonDDMMSS = point.GetAutoLonDegMinSec(lonD, decimalLonM, lonM, lonS);
 			if (!isCenterPoint) {
 				if (latDDMMSS && lonDDMMSS) {
-					if (lastPointWasDDMMSS && latD == lastLatD && latM == lastLatM && latS == lastLatS && lonD == lastLonD && lonM == lastLonM && lonS == lastLonS) return;
+					if (lastPointWasDDMMSS && latD == lastLatD && latM == lastLatM && latS == lastLatS && point.GetNorS() == lastNorS && lonD == lastLonD && lonM == lastLonM && lonS == lastLonS && point.GetEorW() == lastEorW) return;
 					lastPointWasDDMMSS = true;
 					lastLatD = latD;
 					lastLatM = latM;
@@ -811,6 +858,8 @@ void OpenAir::WritePoint(const Geometry::LatLon& point, bool isCenterPoint /* =
 					lastLonD = lonD;
 					lastLonM = lonM;
 					lastLonS = lonS;
+					lastNorS = point.GetNorS();
+					lastEorW = point.GetEorW();
 				} else lastPointWasDDMMSS = false;
 			}
 			if (!isCenterPoint && addPrefix) file << "DP ";
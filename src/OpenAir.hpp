@@ -15,8 +15,12 @@
 #include <map>
 #include <unordered_map>
 #include <fstream>
+#include <memory>
 #include "Airspace.hpp"
 #include "Geometry.hpp"
+#include "ConversionContext.hpp"
+
+class AirspaceStore;
 
 class OpenAir {
 friend class Point;
@@ -24,30 +28,24 @@ friend class Circle;
 friend class Sector;
 
 public:
-	enum CoordinateType {
-		DEG_DECIMAL_MIN = 0,
-		DEG_MIN_SEC,
-		AUTO
-	};
+	typedef ConversionContext::CoordinateType CoordinateType;
 
-	OpenAir(std::multimap<int, Airspace>& airspacesMap);
+	OpenAir(AirspaceStore& airspacesMap, const ConversionContext& conversionContext);
 	~OpenAir() {}
 	bool Read(const std::string& fileName);
 	bool Write(const std::string& fileName);
-	inline static void CalculateArcsAndCirconferences(const bool calcArcs = true) { calculateArcs = calcArcs; }
-	inline static void SetCoordinateType(CoordinateType type) { coordinateType = type; }
 
 private:
 	static std::string& RemoveComments(std::string &s);
 	static bool RemoveNonPrintable(std::string &s);
-	static bool ParseDegrees(const std::string& dddmmss, double& deg, bool isLon = false);
-	static bool ParseCoordinates(const std::string& text, Geometry::LatLon& point);
+	bool ParseDegrees(const std::string& dddmmss, double& deg, bool isLon = false) const;
+	bool ParseCoordinates(const std::string& text, Geometry::LatLon& point) const;
 	static bool ParseAN(const std::string& line, Airspace& airspace);
 	static bool ParseAF(const std::string& line, Airspace& airspace);
-	static bool ParseAltitude(const std::string& line, const bool isTop, Airspace& airspace);
+	bool ParseAltitude(const std::string& line, const bool isTop, Airspace& airspace);
 	static bool ParseS (const std::string& line);
 	static bool ParseT (const std::string& line);
-	static bool ParseDP(const std::string& line, Airspace& airspace, const int& linenumber);
+	bool ParseDP(const std::string& line, Airspace& airspace, const int& linenumber);
 	static bool IsFileUTF8 (std::ifstream& inputFile);
 	static bool CheckAngleDeg(const double& angleDeg);
 	bool ParseAC(const std::string& line, Airspace& airspace);
@@ -55,6 +53,7 @@ private:
 	bool ParseDA(const std::string& line, Airspace& airspace, const int& linenumber);
 	bool ParseDB(const std::string& line, Airspace& airspace);
 	bool ParseDC(const std::string& line, Airspace& airspace);
+	void DiscretizePendingGeometries(Airspace& airspace);
 	bool InsertAirspace(Airspace& airspace);
 	void WriteHeader();
 	bool WriteCategory(const Airspace& airsapce);
@@ -66,15 +65,18 @@ private:
 	void WriteSector(const Sector& sector);
 
 	static const std::unordered_map<std::string, Airspace::Type> openAirAirspaceTable;
-	static bool calculateArcs;
-	static bool lastPointWasEqualToFirst;
-	static CoordinateType coordinateType;
-	static int linecount;
-	std::multimap<int, Airspace>& airspaces;
+	AirspaceStore& airspaces;
+	const ConversionContext& context;
+	bool lastPointWasEqualToFirst;
+	int linecount;
+	std::shared_ptr<const std::string> sourceFile;
 	bool varRotationClockwise;
 	Geometry::LatLon varPoint;
+	size_t firstPendingGeometry; // Arcs and circles are discretized only when needed, so the airspace can be skipped before on their bounding box
+	bool baseFound, topFound;
 	std::ofstream file;
 	int lastACline;
 	bool lastPointWasDDMMSS;
 	int lastLatD, lastLatM, lastLatS, lastLonD, lastLonM, lastLonS;
+	char lastNorS, lastEorW;
 };
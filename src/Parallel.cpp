@@ -0,0 +1,194 @@
+//============================================================================
+// AirspaceConverter
+// Web         : https://www.alus.it/AirspaceConverter
+// Repository  : https://github.com/alus-it/AirspaceConverter.git
+// License     : GNU GPL v3
+//
+// This source file is part of AirspaceConverter project
+//============================================================================
+
+#include "Parallel.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <climits>
+
+// One call of Parallel::For(), its iterations are split in chunks which can be done by any thread
+struct Job {
+	Job(const std::function<void(const size_t)>& function, const size_t numOfChunks) : body(function), pending(numOfChunks) {}
+	const std::function<void(const size_t)>& body;
+	std::atomic<size_t> pending; // Chunks not yet done, the job can't be touched anymore once it is zero
+};
+
+struct Chunk {
+	Job* job;
+	size_t begin, end;
+};
+
+// Each worker takes the last chunk added to its own queue, when empty it steals the first one of the queue of another worker
+class Pool {
+public:
+	Pool(const unsigned int threads);
+	~Pool();
+	void Run(const size_t count, const std::function<void(const size_t)>& body);
+	inline unsigned int GetNumOfThreads() const { return (unsigned int)queues.size() + 1; }
+
+private:
+	struct Queue {
+		std::mutex mutex;
+		std::deque<Chunk> chunks;
+	};
+
+	void Work(const size_t worker);
+	bool Pop(const size_t worker, Chunk& chunk);
+	bool Steal(const size_t thief, Chunk& chunk);
+	void Execute(const Chunk& chunk);
+
+	std::vector<std::unique_ptr<Queue>> queues; // One per worker
+	std::vector<std::thread> workers;
+	std::atomic<size_t> queued; // Chunks waiting in all the queues, or about to be added
+	std::mutex sleepMutex;
+	std::condition_variable wakeUp; // For the workers, when chunks are added or the pool stops
+	std::condition_variable jobDone; // For the threads waiting the end of their job, also when chunks are added
+	bool stop;
+};
+
+static const size_t NOT_A_WORKER = SIZE_MAX;
+static thread_local size_t workerIndex = NOT_A_WORKER; // Queue of the current thread if it is a worker of a pool
+static thread_local Pool* workerPool = nullptr; // Pool of the current thread if it is a worker, kept alive by the job it is helping
+static const size_t CHUNKS_PER_THREAD = 8; // More chunks than threads, so the ones done first can steal from the others
+static std::atomic<unsigned int> numOfThreads(std::max(1u, std::thread::hardware_concurrency()));
+static std::mutex poolMutex;
+static std::shared_ptr<Pool> pool; // Started at first use, each job holds it so it can be replaced while working
+
+Pool::Pool(const unsigned int threads) :
+	queued(0),
+	stop(false) {
+	for (unsigned int t = 1; t < threads; t++) queues.push_back(std::make_unique<Queue>()); // The calling thread is the remaining one
+	workers.reserve(queues.size());
+	for (size_t w = 0; w < queues.size(); w++) workers.emplace_back(&Pool::Work, this, w);
+}
+
+Pool::~Pool() {
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		stop = true;
+	}
+	wakeUp.notify_all();
+	for (std::thread& t : workers) t.join();
+}
+
+void Pool::Run(const size_t count, const std::function<void(const size_t)>& body) {
+	if (queues.empty()) { // No workers, not even to deal the chunks
+		for (size_t i = 0; i < count; i++) body(i);
+		return;
+	}
+	const size_t numOfChunks = std::min(count, CHUNKS_PER_THREAD * GetNumOfThreads());
+	Job job(body, numOfChunks);
+
+	// A worker keeps the chunks in its own queue, the others are going to steal them; otherwise they are dealt to all the workers
+	const size_t worker = workerIndex;
+	queued += numOfChunks; // Counted before, so it is never less than the chunks in the queues
+	for (size_t c = 0; c < numOfChunks; c++) {
+		Queue& queue = *queues[worker != NOT_A_WORKER ? worker : c % queues.size()];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.chunks.push_back({ &job, count * c / numOfChunks, count * (c + 1) / numOfChunks });
+	}
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex); // So no worker can miss the notification between checking the queues and going to sleep
+	}
+	wakeUp.notify_all();
+	jobDone.notify_all(); // The threads waiting for their jobs can help with this one
+
+	// Help until all the chunks of this job are done, also doing chunks of other jobs
+	Chunk chunk;
+	while (job.pending.load(std::memory_order_acquire) > 0) {
+		if ((worker != NOT_A_WORKER && Pop(worker, chunk)) || Steal(worker, chunk)) {
+			Execute(chunk);
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(sleepMutex); // The last chunks are being done by other threads
+		jobDone.wait(lock, [&job, this]() { return job.pending.load(std::memory_order_acquire) == 0 || queued > 0; });
+	}
+}
+
+void Pool::Work(const size_t worker) {
+	workerIndex = worker;
+	workerPool = this;
+	Chunk chunk;
+	while (true) {
+		if (Pop(worker, chunk) || Steal(worker, chunk)) {
+			Execute(chunk);
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		wakeUp.wait(lock, [this]() { return stop || queued > 0; });
+		if (stop) return;
+	}
+}
+
+bool Pool::Pop(const size_t worker, Chunk& chunk) {
+	Queue& queue = *queues[worker];
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	if (queue.chunks.empty()) return false;
+	chunk = queue.chunks.back();
+	queue.chunks.pop_back();
+	queued--;
+	return true;
+}
+
+bool Pool::Steal(const size_t thief, Chunk& chunk) {
+	const size_t numOfQueues = queues.size();
+	const size_t first = thief != NOT_A_WORKER ? thief + 1 : 0;
+	for (size_t q = 0; q < numOfQueues; q++) {
+		const size_t victim = (first + q) % numOfQueues;
+		if (victim == thief) continue;
+		Queue& queue = *queues[victim];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.chunks.empty()) continue;
+		chunk = queue.chunks.front();
+		queue.chunks.pop_front();
+		queued--;
+		return true;
+	}
+	return false;
+}
+
+void Pool::Execute(const Chunk& chunk) {
+	for (size_t i = chunk.begin; i < chunk.end; i++) chunk.job->body(i);
+	if (chunk.job->pending.fetch_sub(1, std::memory_order_acq_rel) > 1) return; // From here the job may not exist anymore
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex); // So the thread of the job can't miss the notification between checking and going to sleep
+	}
+	jobDone.notify_all();
+}
+
+void Parallel::SetNumOfThreads(const unsigned int threads) {
+	const unsigned int newNumOfThreads = threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+	std::lock_guard<std::mutex> lock(poolMutex);
+	if (pool && pool->GetNumOfThreads() != newNumOfThreads) pool.reset(); // The current workers stop when their last job ends, the new ones will be started at first use
+	numOfThreads = newNumOfThreads;
+}
+
+unsigned int Parallel::GetNumOfThreads() {
+	return numOfThreads;
+}
+
+void Parallel::Run(const size_t count, const std::function<void(const size_t)>& body) {
+	if (workerPool != nullptr) { // Called by a worker: its queue is in its own pool, even if meanwhile replaced
+		workerPool->Run(count, body);
+		return;
+	}
+	std::shared_ptr<Pool> currentPool;
+	{
+		std::lock_guard<std::mutex> lock(poolMutex);
+		if (!pool) pool = std::make_shared<Pool>(numOfThreads);
+		currentPool = pool;
+	}
+	currentPool->Run(count, body);
+}
@@ -0,0 +1,32 @@
+//============================================================================
+// AirspaceConverter
+// Web         : https://www.alus.it/AirspaceConverter
+// Repository  : https://github.com/alus-it/AirspaceConverter.git
+// License     : GNU GPL v3
+//
+// This source file is part of AirspaceConverter project
+//============================================================================
+
+#pragma once
+#include <functional>
+
+// Parallel work of the whole library, done by one process wide pool of threads stealing work from each other
+class Parallel {
+public:
+	// Call body(i) for each i from 0 to count-1 using the threads of the pool, the calling thread works as well.
+	// The body must not throw and must not touch data used by other iterations, it can call For() again.
+	template<typename Function>
+	static void For(const size_t count, const Function& body) {
+		if (count <= 1 || GetNumOfThreads() <= 1) {
+			for (size_t i = 0; i < count; i++) body(i);
+			return;
+		}
+		Run(count, std::function<void(const size_t)>(std::cref(body)));
+	}
+
+	static void SetNumOfThreads(const unsigned int threads); // Including the calling one, 0 for one per core, 1 to work serially; the work already started ends on the old threads
+	static unsigned int GetNumOfThreads();
+
+private:
+	static void Run(const size_t count, const std::function<void(const size_t)>& body);
+};
@@ -13,6 +13,7 @@
 #include "Polish.hpp"
 #include "AirspaceConverter.hpp"
 #include "Airspace.hpp"
+#include "AirspaceStore.hpp"
 #include <sstream>
 #include <filesystem>
 #include <cassert>
@@ -91,8 +92,8 @@ void Polish::WriteHeader(const std::string& filename) {
 		<< "[END]\n\n";
 }
 
-bool Polish::Write(const std::string& filename, const std::multimap<int, Airspace>& airspaces) {
-	if (airspaces.empty()) {
+bool Polish::Write(const std::string& filename, const AirspaceStore& airspaces) {
+	if (airspaces.Empty()) {
 		AirspaceConverter::LogMessage("Polish output: no airspace, nothing to write");
 		return false;
 	}
@@ -114,10 +115,8 @@ bool Polish::Write(const std::string& filename, const std::multimap<int, Airspac
 	WriteHeader(filename);
 
 	// Go trough all airspaces
-	for (const std::pair<const int,Airspace>& pair : airspaces)
+	for (const Airspace& a : airspaces)
 	{
-		// Get the airspace
-		const Airspace& a = pair.second;
 
 		// Just a couple if assertions
 		assert(a.GetNumberOfPoints() > 3);
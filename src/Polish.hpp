@@ -16,12 +16,13 @@
 #include <fstream>
 
 class Airspace;
+class AirspaceStore;
 
 class Polish {
 public:
 	Polish() {}
 	~Polish() {}
-	bool Write(const std::string& filename, const std::multimap<int, Airspace>& airspaces);
+	bool Write(const std::string& filename, const AirspaceStore& airspaces);
 
 private:
 	void WriteHeader(const std::string& filename);
@@ -14,6 +14,8 @@
 #include "AirspaceConverter.hpp"
 #include "Waypoint.hpp"
 #include "Airfield.hpp"
+#include "WaypointStore.hpp"
+#include "ConversionContext.hpp"
 #include "Airspace.hpp"
 #include "Geometry.hpp"
 #include <fstream>
@@ -26,8 +28,9 @@
 
 const std::string SeeYou::defaultHeader = "name,code,country,lat,lon,elev,style,rwdir,rwlen,freq,desc";
 
-SeeYou::SeeYou(std::multimap<int,Waypoint*>& waypointsMap):
-	waypoints(waypointsMap) {
+SeeYou::SeeYou(WaypointStore& waypointsStore, const ConversionContext& conversionContext):
+	waypoints(waypointsStore),
+	context(conversionContext) {
 }
 
 bool SeeYou::ParseLatitude(const std::string& text, double& lat) {
@@ -180,7 +183,7 @@ bool SeeYou::Read(const std::string& fileName) {
 	double latitude, longitude;
 	int type, runwayDir, runwayLength, radioFreq, altRadioFreq;
 	float altitude = 0;
-	const bool terrainMapsPresent(AirspaceConverter::GetNumOfTerrainMaps() > 0);
+	const bool terrainMapsPresent(!context.terrainMaps->Empty());
 
 	while (!input.eof() && input.good()) {
 
@@ -281,7 +284,10 @@ bool SeeYou::Read(const std::string& fileName) {
 
 		// Altitude verification against terrain raster map
 		if (terrainMapsPresent && type > Waypoint::WaypointType::normal) // Unknown and normal waypoints skipped
-			AirspaceConverter::VerifyAltitudeOnTerrainMap(latitude,longitude,altitude,blankAltitude,altitudeParsed,linecount,type >= Waypoint::WaypointType::mtTop && type <= Waypoint::WaypointType::dam);
+			context.VerifyAltitudeOnTerrainMap(latitude,longitude,altitude,blankAltitude,altitudeParsed,linecount,type >= Waypoint::WaypointType::mtTop && type <= Waypoint::WaypointType::dam);
+
+		// Skip it if it is going to be filtered out anyway
+		if (context.IsWaypointExcluded(Geometry::LatLon(latitude, longitude), altitude)) continue;
 
 		// If it's an airfield...
 		if(Waypoint::IsTypeAirfield((Waypoint::WaypointType)type)) {
@@ -302,15 +308,15 @@ bool SeeYou::Read(const std::string& fileName) {
 			assert(token != tokens.end());
 
 			// Build the airfield
-			Airfield* airfield = new Airfield(name, code, country, latitude, longitude, altitude, type, runwayDir, runwayLength, radioFreq, description);
+			Airfield airfield(name, code, country, latitude, longitude, altitude, type, runwayDir, runwayLength, radioFreq, description);
 			if (altRadioFreq > 0) {
 				assert(radioFreq > 0);
 				if (altRadioFreq == radioFreq) AirspaceConverter::LogWarning(std::format("on line {}: skipping repeated secondary radio frequency for airfield.", linecount));
-				else airfield->SetOtherFrequency(altRadioFreq);
+				else airfield.SetOtherFrequency(altRadioFreq);
 			}
 
-			// Add it to the multimap
-			waypoints.insert(std::pair<int, Waypoint*>(type, (Waypoint*)airfield));
+			// Add it to the store
+			waypoints.Add(airfield);
 		} else {
 			// Skip runway length and direction
 			token++;
@@ -325,18 +331,18 @@ bool SeeYou::Read(const std::string& fileName) {
 			assert(token != tokens.end());
 
 			// Build the waypoint
-			Waypoint* waypoint = new Waypoint(name, code, country, latitude, longitude, altitude, type, description);
-			if (radioFreq > 0) waypoint->SetOtherFrequency(radioFreq);
+			Waypoint waypoint(name, code, country, latitude, longitude, altitude, type, description);
+			if (radioFreq > 0) waypoint.SetOtherFrequency(radioFreq);
 
-			// Add it to the multimap
-			waypoints.insert(std::pair<int, Waypoint*>(type, waypoint));
+			// Add it to the store
+			waypoints.Add(waypoint);
 		}
 	}
 	return true;
 }
 
 bool SeeYou::Write(const std::string& fileName) {
-	if (waypoints.empty()) {
+	if (waypoints.Empty()) {
 		AirspaceConverter::LogMessage("SeeYou output: no waypoints, nothing to write");
 		return false;
 	}
@@ -352,13 +358,11 @@ bool SeeYou::Write(const std::string& fileName) {
 	file << "name,code,country,lat,lon,elev,style,rwdir,rwlen,freq,desc\r\n";
 
 	// Go trough all waypoints
-	for (const std::pair<const int,Waypoint*>& pair : waypoints) {
-		assert(pair.second != nullptr);
-		const Waypoint& w(*pair.second);
+	for (const WaypointStore::Entry w : waypoints) {
 
 		// Name is mandatory according to SeeYou specs
 		if (w.GetName().empty()) {
-			AirspaceConverter::LogWarning("skipping waypoint with long name empty: " + w.GetCode());
+			AirspaceConverter::LogWarning("skipping waypoint with long name empty: " + std::string(w.GetCode()));
 			continue;
 		}
 
@@ -391,20 +395,18 @@ bool SeeYou::Write(const std::string& fileName) {
 		file << (int)w.GetType() << ',';
 
 		if (w.IsAirfield()) {
-			const Airfield& a((const Airfield&)w);
-
 			// Runway direction
-			if (a.HasRunwayDir()) file << std::setw(3) << a.GetRunwayDir();
+			if (w.HasRunwayDir()) file << std::setw(3) << w.GetRunwayDir();
 			file << ',';
 
 			// Runway length
-			if (a.HasRunwayLength()) file << a.GetRunwayLength() << 'm';
+			if (w.HasRunwayLength()) file << w.GetRunwayLength() << 'm';
 			file << ',';
 
 			// Radio frequency
-			if (a.HasRadioFrequency()) {
-				file << std::setprecision(3) << AirspaceConverter::FrequencyMHz(a.GetRadioFrequency());
-				if (a.HasOtherFrequency()) file << '-' << AirspaceConverter::FrequencyMHz(a.GetOtherFrequency());
+			if (w.HasRadioFrequency()) {
+				file << std::setprecision(3) << AirspaceConverter::FrequencyMHz(w.GetRadioFrequency());
+				if (w.HasOtherFrequency()) file << '-' << AirspaceConverter::FrequencyMHz(w.GetOtherFrequency());
 			}
 		} else {
 			file << ",,"; // Skip runway length and direction
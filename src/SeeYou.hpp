@@ -15,11 +15,13 @@
 #include <map>
 
 class Waypoint;
+class WaypointStore;
+struct ConversionContext;
 
 class SeeYou {
 
 public:
-	SeeYou(std::multimap<int,Waypoint*>& waypointsMap);
+	SeeYou(WaypointStore& waypointsStore, const ConversionContext& conversionContext);
 	~SeeYou() {}
 	bool Read(const std::string& fileName);
 	bool Write(const std::string& fileName);
@@ -35,5 +37,6 @@ private:
 	static bool ParseOtherFrequency(const std::string& text, const int type, int& freqHz);
 
 	static const std::string defaultHeader;
-	std::multimap<int,Waypoint*>& waypoints;
+	WaypointStore& waypoints;
+	const ConversionContext& context;
 };
@@ -0,0 +1,63 @@
+//============================================================================
+// AirspaceConverter
+// Web         : https://www.alus.it/AirspaceConverter
+// Repository  : https://github.com/alus-it/AirspaceConverter.git
+// License     : GNU GPL v3
+//
+// This source file is part of AirspaceConverter project
+//============================================================================
+
+#include "StringPool.hpp"
+#include <tuple>
+
+InternedString::InternedString() {
+	static StringPool::Entry* const emptyText = StringPool::Intern(std::string_view()); // Looked up only once, its handle is never released
+	entry = emptyText;
+	entry->second.fetch_add(1, std::memory_order_relaxed);
+}
+
+InternedString::InternedString(const std::string_view text)
+	: entry(StringPool::Intern(text)) {
+}
+
+InternedString::InternedString(const InternedString& other)
+	: entry(other.entry) {
+	entry->second.fetch_add(1, std::memory_order_relaxed);
+}
+
+InternedString::~InternedString() {
+	entry->second.fetch_sub(1, std::memory_order_release);
+}
+
+InternedString& InternedString::operator=(const InternedString& other) {
+	other.entry->second.fetch_add(1, std::memory_order_relaxed);
+	entry->second.fetch_sub(1, std::memory_order_release);
+	entry = other.entry;
+	return *this;
+}
+
+StringPool& StringPool::Instance() {
+	static StringPool pool; // Built at first use, so it is available also during static initialization
+	return pool;
+}
+
+StringPool::Entry* StringPool::Intern(const std::string_view text) {
+	StringPool& pool(Instance());
+	std::lock_guard<std::mutex> lock(pool.mutex); // Also against a purge, so an entry found here can't be released in the meantime
+	std::unordered_map<std::string, std::atomic<size_t>, TextHash, std::equal_to<>>::iterator it = pool.texts.find(text);
+	if (it == pool.texts.end()) it = pool.texts.emplace(std::piecewise_construct, std::forward_as_tuple(text), std::forward_as_tuple(0)).first;
+	it->second.fetch_add(1, std::memory_order_relaxed);
+	return &(*it);
+}
+
+size_t StringPool::Purge() {
+	StringPool& pool(Instance());
+	std::lock_guard<std::mutex> lock(pool.mutex);
+	return std::erase_if(pool.texts, [](const Entry& e) { return e.second.load(std::memory_order_acquire) == 0; });
+}
+
+size_t StringPool::Size() {
+	StringPool& pool(Instance());
+	std::lock_guard<std::mutex> lock(pool.mutex);
+	return pool.texts.size();
+}
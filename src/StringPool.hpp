@@ -0,0 +1,62 @@
+//============================================================================
+// AirspaceConverter
+// Web         : https://www.alus.it/AirspaceConverter
+// Repository  : https://github.com/alus-it/AirspaceConverter.git
+// License     : GNU GPL v3
+//
+// This source file is part of AirspaceConverter project
+//============================================================================
+
+#pragma once
+#include <string>
+#include <string_view>
+#include <ostream>
+#include <unordered_map>
+#include <utility>
+#include <atomic>
+#include <functional>
+#include <mutex>
+
+// Pool of all the texts read, each distinct text is kept only once and only while there are handles to it
+class StringPool {
+public:
+	typedef std::pair<const std::string, std::atomic<size_t>> Entry; // The text and the number of handles to it
+
+	static Entry* Intern(const std::string_view text); // Thread safe, the entry is returned already counting one more handle
+	static size_t Purge(); // Release the texts without handles, returns how many were released
+	static size_t Size(); // Number of distinct texts in the pool
+
+private:
+	// Hash usable with both std::string and std::string_view, so the lookup doesn't need to build a string
+	struct TextHash {
+		using is_transparent = void;
+		inline size_t operator()(const std::string_view text) const { return std::hash<std::string_view>()(text); }
+	};
+
+	StringPool() {}
+	static StringPool& Instance();
+
+	std::mutex mutex;
+	std::unordered_map<std::string, std::atomic<size_t>, TextHash, std::equal_to<>> texts; // The nodes are never moved, so the addresses of the entries are stable
+};
+
+// Handle to a string kept only once in the StringPool: compared by address, it keeps the text in the pool
+class InternedString {
+public:
+	InternedString(); // The empty string
+	explicit InternedString(const std::string_view text);
+	InternedString(const InternedString& other);
+	~InternedString();
+	InternedString& operator=(const InternedString& other);
+	inline InternedString& operator=(InternedString&& other) noexcept { std::swap(entry, other.entry); return *this; }
+
+	inline const std::string& Get() const { return entry->first; }
+	inline bool empty() const { return entry->first.empty(); }
+	inline size_t size() const { return entry->first.size(); }
+	inline bool operator==(const InternedString& other) const { return entry == other.entry; } // Same text only if same address
+
+private:
+	StringPool::Entry* entry; // Never null
+};
+
+inline std::ostream& operator<<(std::ostream& os, const InternedString& s) { return os << s.Get(); }
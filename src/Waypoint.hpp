@@ -13,6 +13,7 @@
 #pragma once
 #include <string>
 #include "Geometry.hpp"
+#include "StringPool.hpp"
 
 class Waypoint {
 
@@ -46,16 +47,20 @@ public:
 	inline static bool IsTypeAirfield(const Waypoint::WaypointType& kind) { return kind >= airfieldGrass && kind <= airfieldSolid; }
 	inline static bool IsTypeAirfield(const int& kind) { return kind >= airfieldGrass && kind <= airfieldSolid; }
 
-	inline const std::string& GetName() const { return name; }
-	inline const std::string& GetCode() const { return code; }
-	inline const std::string& GetCountry() const { return country; }
+	inline const std::string& GetName() const { return name.Get(); }
+	inline const std::string& GetCode() const { return code.Get(); }
+	inline const std::string& GetCountry() const { return country.Get(); }
 	inline const Geometry::LatLon& GetPosition() const { return pos; }
 	inline double GetLatitude() const { return pos.Lat(); }
 	inline double GetLongitude() const { return pos.Lon(); }
 	inline float GetAltitude() const { return altitude; }
 	inline WaypointType GetType() const { return type; }
 	inline const std::string& GetTypeName() const { return TypeName(type); }
-	inline const std::string& GetDescription() const { return description; }
+	inline const std::string& GetDescription() const { return description.Get(); }
+	inline const InternedString& GetInternedName() const { return name; } // Handles to the texts, to compare them just by address
+	inline const InternedString& GetInternedCode() const { return code; }
+	inline const InternedString& GetInternedCountry() const { return country; }
+	inline const InternedString& GetInternedDescription() const { return description; }
 	inline bool IsAirfield() const { return IsTypeAirfield(type); }
 	inline void SetOtherFrequency(const int freq) { otherFreq = freq; }
 	inline bool HasOtherFrequency() const { return otherFreq > 0; }
@@ -66,13 +71,13 @@ public:
 
 private:
 	Geometry::LatLon pos;
-	std::string name;
-	std::string code;
-	std::string country;
+	InternedString name;
+	InternedString code;
+	InternedString country;
 	float altitude; // [m]
 	WaypointType type;
 	int otherFreq; // [Hz] frequency for VOR NDB or secondary radio frequency for airports
-	std::string description;
+	InternedString description;
 	static const std::string TYPE_NAMES[];
 };
 
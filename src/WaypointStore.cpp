@@ -0,0 +1,85 @@
+//============================================================================
+// AirspaceConverter
+// Web         : https://www.alus.it/AirspaceConverter
+// Repository  : https://github.com/alus-it/AirspaceConverter.git
+// License     : GNU GPL v3
+//
+// This source file is part of AirspaceConverter project
+//============================================================================
+
+#include "WaypointStore.hpp"
+#include "Airfield.hpp"
+#include <algorithm>
+#include <cassert>
+
+void WaypointStore::Add(const Waypoint& waypoint) {
+	AddCommon(waypoint);
+	runwayDirs.push_back(-1);
+	runwayLengths.push_back(-1);
+	radioFrequencies.push_back(-1);
+}
+
+void WaypointStore::Add(const Airfield& airfield) {
+	AddCommon(airfield);
+	runwayDirs.push_back(airfield.GetRunwayDir());
+	runwayLengths.push_back(airfield.GetRunwayLength());
+	radioFrequencies.push_back(airfield.GetRadioFrequency());
+}
+
+void WaypointStore::AddCommon(const Waypoint& waypoint) {
+	assert(waypoint.GetType() >= 0 && waypoint.GetType() < Waypoint::numOfWaypointTypes);
+	positions.push_back(waypoint.GetPosition());
+	altitudes.push_back(waypoint.GetAltitude());
+	types.push_back(waypoint.GetType());
+	otherFrequencies.push_back(waypoint.GetOtherFrequency());
+	names.push_back(waypoint.GetInternedName());
+	codes.push_back(waypoint.GetInternedCode());
+	countries.push_back(waypoint.GetInternedCountry());
+	descriptions.push_back(waypoint.GetInternedDescription());
+	byType[waypoint.GetType()].push_back((std::uint32_t)(types.size() - 1));
+}
+
+void WaypointStore::Clear() {
+	*this = WaypointStore();
+	StringPool::Purge(); // The texts of the waypoints destroyed are no longer needed
+}
+
+size_t WaypointStore::Remove(const std::vector<unsigned char>& toRemove) {
+	assert(toRemove.size() == Size());
+	if (std::none_of(toRemove.begin(), toRemove.end(), [](const unsigned char r) { return r != 0; })) return 0;
+
+	// Move each remaining waypoint in its new position
+	size_t kept(0);
+	for (size_t i = 0; i < toRemove.size(); i++) {
+		if (toRemove[i]) continue;
+		positions[kept] = positions[i];
+		altitudes[kept] = altitudes[i];
+		types[kept] = types[i];
+		otherFrequencies[kept] = otherFrequencies[i];
+		runwayDirs[kept] = runwayDirs[i];
+		runwayLengths[kept] = runwayLengths[i];
+		radioFrequencies[kept] = radioFrequencies[i];
+		names[kept] = names[i];
+		codes[kept] = codes[i];
+		countries[kept] = countries[i];
+		descriptions[kept] = descriptions[i];
+		kept++;
+	}
+	const size_t removed(Size() - kept);
+	positions.resize(kept);
+	altitudes.resize(kept);
+	types.resize(kept);
+	otherFrequencies.resize(kept);
+	runwayDirs.resize(kept);
+	runwayLengths.resize(kept);
+	radioFrequencies.resize(kept);
+	names.resize(kept);
+	codes.resize(kept);
+	countries.resize(kept);
+	descriptions.resize(kept);
+
+	// Rebuild the indexes by type, the order of insertion is preserved
+	for (std::vector<std::uint32_t>& indexes : byType) indexes.clear();
+	for (size_t i = 0; i < kept; i++) byType[types[i]].push_back((std::uint32_t)i);
+	return removed;
+}
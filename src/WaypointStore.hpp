@@ -0,0 +1,101 @@
+//============================================================================
+// AirspaceConverter
+// Web         : https://www.alus.it/AirspaceConverter
+// Repository  : https://github.com/alus-it/AirspaceConverter.git
+// License     : GNU GPL v3
+//
+// This source file is part of AirspaceConverter project
+//============================================================================
+
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <iterator>
+#include "Waypoint.hpp"
+
+class Airfield;
+
+// Waypoints kept by columns: one array per field, the texts as handles to the StringPool, visited by type and then in order of insertion
+class WaypointStore {
+public:
+	// Read only view of one waypoint in the store, with the same accessors of Waypoint and Airfield
+	class Entry {
+	public:
+		Entry(const WaypointStore& waypointStore, const size_t i) : store(&waypointStore), index(i) {}
+		inline const std::string& GetName() const { return store->names[index].Get(); }
+		inline const InternedString& GetInternedName() const { return store->names[index]; } // To compare names just by address
+		inline const std::string& GetCode() const { return store->codes[index].Get(); }
+		inline const std::string& GetCountry() const { return store->countries[index].Get(); }
+		inline const std::string& GetDescription() const { return store->descriptions[index].Get(); }
+		inline const Geometry::LatLon& GetPosition() const { return store->positions[index]; }
+		inline double GetLatitude() const { return GetPosition().Lat(); }
+		inline double GetLongitude() const { return GetPosition().Lon(); }
+		inline float GetAltitude() const { return store->altitudes[index]; }
+		inline Waypoint::WaypointType GetType() const { return store->types[index]; }
+		inline const std::string& GetTypeName() const { return Waypoint::TypeName(GetType()); }
+		inline bool IsAirfield() const { return Waypoint::IsTypeAirfield(GetType()); }
+		inline bool HasOtherFrequency() const { return store->otherFrequencies[index] > 0; }
+		inline int GetOtherFrequency() const { return store->otherFrequencies[index]; }
+		inline int GetRunwayDir() const { return store->runwayDirs[index]; }
+		inline int GetRunwayLength() const { return store->runwayLengths[index]; }
+		inline int GetRadioFrequency() const { return store->radioFrequencies[index]; }
+		inline bool HasRunwayDir() const { return store->runwayDirs[index] > 0; }
+		inline bool HasRunwayLength() const { return store->runwayLengths[index] > 0; }
+		inline bool HasRadioFrequency() const { return store->radioFrequencies[index] > 0; }
+
+	private:
+		const WaypointStore* store;
+		size_t index;
+	};
+
+	class Iterator {
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = Entry;
+		using difference_type = std::ptrdiff_t;
+		using pointer = void;
+		using reference = Entry;
+
+		Iterator(const WaypointStore* s, const int t, const size_t p) : store(s), type(t), pos(p) { SkipEmpty(); }
+		inline Entry operator*() const { return Entry(*store, store->byType[type][pos]); }
+		inline Iterator& operator++() { ++pos; SkipEmpty(); return *this; }
+		inline Iterator operator++(int) { Iterator it(*this); ++(*this); return it; }
+		inline bool operator==(const Iterator& other) const { return type == other.type && pos == other.pos; }
+
+	private:
+		inline void SkipEmpty() { while (type < Waypoint::numOfWaypointTypes && pos >= store->byType[type].size()) { ++type; pos = 0; } }
+		const WaypointStore* store;
+		int type;
+		size_t pos;
+	};
+
+	WaypointStore() {}
+
+	void Add(const Waypoint& waypoint);
+	void Add(const Airfield& airfield);
+	void Clear(); // Release all the columns at once, and the texts no longer used from the StringPool
+	size_t Remove(const std::vector<unsigned char>& toRemove); // Remove the waypoints flagged, in order of insertion
+	inline size_t Size() const { return types.size(); }
+	inline bool Empty() const { return types.empty(); }
+	inline size_t Count(const int type) const { return byType[type].size(); }
+	inline Entry At(const size_t i) const { return Entry(*this, i); } // In order of insertion
+	inline const std::vector<std::uint32_t>& IndexesOfType(const int type) const { return byType[type]; } // In order of insertion
+	inline const std::vector<Geometry::LatLon>& GetPositions() const { return positions; } // In order of insertion
+	inline const std::vector<float>& GetAltitudes() const { return altitudes; } // In order of insertion
+	inline Iterator begin() const { return Iterator(this, 0, 0); }
+	inline Iterator end() const { return Iterator(this, Waypoint::numOfWaypointTypes, 0); }
+
+private:
+	void AddCommon(const Waypoint& waypoint);
+
+	std::vector<Geometry::LatLon> positions;
+	std::vector<float> altitudes; // [m]
+	std::vector<Waypoint::WaypointType> types;
+	std::vector<int> otherFrequencies; // [Hz]
+	std::vector<int> runwayDirs; // [deg] negative if not known or not an airfield
+	std::vector<int> runwayLengths; // [m] negative if not known or not an airfield
+	std::vector<int> radioFrequencies; // [Hz] negative if not known or not an airfield
+	std::vector<InternedString> names, codes, countries, descriptions;
+	std::vector<std::uint32_t> byType[Waypoint::numOfWaypointTypes]; // Indexes of the waypoints of each type
+};
@@ -27,15 +27,28 @@ void printHelp() {
 	std::cout << "-m: optional, multiple, terrain map file(s) (.dem) used to lookup terrain heights" << std::endl;
 	std::cout << "-l: optional, set filter limits in latitude, longitude for the output, followed by the 4 limit values: northLat,southLat,westLon,eastLon" << std::endl;
 	std::cout << "    where the limits are comma separated, coordinates expressed in degrees, without spaces, negative for west longitudes and south latitudes" << std::endl;
+	std::cout << "-k: optional, with -l cut the airspaces on the limits instead of keeping entirely the ones having at least a point within them" << std::endl;
 	std::cout << "-u: optional, set filter limits on altitude for the output, followed by the 1 or 2 limit values: lowAlt,hiAlt" << std::endl;
 	std::cout << "    altitudes are expressed in feet, at main sea level. If higher limit is omitted it will be considered as unlimited" << std::endl;
+	std::cout << "-y: optional, read only the airspaces of the categories listed after it, comma separated, e.g.: \"Class C,Class D,CTR,TMA\"" << std::endl;
+	std::cout << "-n: optional, skip the airspaces of the categories listed after it, comma separated, e.g.: FIR,UIR,AWY,OTH" << std::endl;
+	std::cout << "-j: optional, merge the touching airspaces having same category, class and vertical limits" << std::endl;
+	std::cout << "-e: optional, write a CSV report of the overlapping airspaces, with the area and the vertical limits of the overlaps, followed by the report file" << std::endl;
+	std::cout << "-x: optional, simplify the airspace borders, followed by the tolerance in meters and optionally the max number of points per airspace: tolerance,maxPoints" << std::endl;
+	std::cout << "    with tolerance 0 only the max number of points is considered, the simplified borders will never intersect themselves" << std::endl;
 	std::cout << "-o: optional, output file .kmz (Google Earth), .opnair, .txt (OpenAir), .cup (SeeYou), .csv (LittleNavMap)";
 	if (AirspaceConverter::Is_cGPSmapperAvailable()) std::cout << ", .img (Garmin)";
 	std::cout << " or .mp (Polish). If not specified will be used the name of first input file as KMZ" << std::endl;
 	std::cout << "-p: optional, when writing in OpenAir avoid to use arcs and circles but only points (DP)" << std::endl;
+	std::cout << "-f: optional, when writing in OpenAir find arcs and circles with least squares fitting, followed by the tolerance in meters (max 100)" << std::endl;
 	std::cout << "-s: optional, when writing in OpenAir use coordinates always with seconds (DD:MM:SS)" << std::endl;
 	std::cout << "-d: optional, when writing in OpenAir use coordinates always with decimal minutes (DD:MM.MMM)" << std::endl;
+	std::cout << "-z: optional, when writing in KMZ calculate area and perimeter of the airspaces with a faster spherical approximation" << std::endl;
 	std::cout << "-t: optional, when reading KML/KMZ files treat also tracks as airspaces" << std::endl;
+	std::cout << "-g: optional, when reading OpenAir files the maximum distance between the points of arcs and circles, followed by the distance in NM (default 0.3, max 10)" << std::endl;
+	std::cout << "-c: optional, check and report the airspaces with self intersecting borders" << std::endl;
+	std::cout << "-r: optional, like -c but repair the self intersecting airspaces removing spikes or exclude them from the output if not possible" << std::endl;
+	std::cout << "--threads: optional, followed by the number of threads to use, 1 to work serially. If not specified one per core" << std::endl;
 	std::cout << "-v: print version number" << std::endl;
 	std::cout << "-h: print this guide" << std::endl << std::endl;
 	std::cout << "At least one input airspace or waypoint file must be present." << std::endl;
@@ -51,14 +64,18 @@ int main(int argc, char *argv[]) {
 	}
 
 	AirspaceConverter ac;
-	bool positionLimitsAreSet(false), altitudeLimitsAreSet(false);
+	bool positionLimitsAreSet(false), clipOnPositionLimits(false), altitudeLimitsAreSet(false), checkSelfIntersections(false), repairSelfIntersections(false);
 	double topLat(90), bottomLat(-90), leftLon(-180), rightLon(180);
 	Altitude limitLowAltitude(-10000), limitHiAltitude;
 	limitHiAltitude.SetUnlimited();
+	bool dissolve(false), simplify(false);
+	std::string overlapsReportFile;
+	double simplifyToleranceMt(0);
+	size_t simplifyMaxPoints(0);
 
 	for(int i=1; i<argc; i++) {
 		size_t len=strlen(argv[i]);
-		if(len != 2 || argv[i][0]!='-') {
+		if((len != 2 && strcmp(argv[i], "--threads") != 0) || argv[i][0]!='-') {
 			std::cerr << "Expected an option but found: " << argv[i] << std::endl << std::endl;
 			return EXIT_FAILURE;
 		}
@@ -75,11 +92,11 @@ int main(int argc, char *argv[]) {
 			}
 			break;
 		case 'a':
-			if(!hasValueAfter) std::cerr << "ERROR: default altitude value not found, using default value: " << AirspaceConverter::GetDefaultTerrainAlt() << " m."<< std::endl;
+			if(!hasValueAfter) std::cerr << "ERROR: default altitude value not found, using default value: " << ac.GetDefaultTerrainAlt() << " m."<< std::endl;
 			else try {
-				AirspaceConverter::SetDefaultTerrainAlt(std::stod(argv[++i]));
+				ac.SetDefaultTerrainAlt(std::stod(argv[++i]));
 			} catch (...) {
-				std::cerr << "ERROR: default altitude value not valid, using default value: " << AirspaceConverter::GetDefaultTerrainAlt() << " m." << std::endl;
+				std::cerr << "ERROR: default altitude value not valid, using default value: " << ac.GetDefaultTerrainAlt() << " m." << std::endl;
 			}
 			break;
 		case 'i':
@@ -130,6 +147,9 @@ int main(int argc, char *argv[]) {
 				}
 			}
 			break;
+		case 'k':
+			clipOnPositionLimits = true;
+			break;
 		case 'u':
 			if (!hasValueAfter) std::cerr << "ERROR: altitude limits not found." << std::endl;
 			else {
@@ -157,9 +177,59 @@ int main(int argc, char *argv[]) {
 				}
 			}
 			break;
+		case 'y':
+			if (!hasValueAfter) std::cerr << "ERROR: categories to include not found." << std::endl;
+			else if (!ac.FilterOnCategories(argv[++i], true)) std::cerr << "ERROR: categories to include not valid." << std::endl;
+			break;
+		case 'n':
+			if (!hasValueAfter) std::cerr << "ERROR: categories to exclude not found." << std::endl;
+			else if (!ac.FilterOnCategories(argv[++i])) std::cerr << "ERROR: categories to exclude not valid." << std::endl;
+			break;
+		case 'j':
+			dissolve = true;
+			break;
+		case 'e':
+			if (!hasValueAfter) std::cerr << "ERROR: overlaps report file path not found." << std::endl;
+			else overlapsReportFile = argv[++i];
+			break;
+		case 'x':
+			if (!hasValueAfter) std::cerr << "ERROR: simplification tolerance not found." << std::endl;
+			else {
+				const std::string params(argv[++i]);
+				boost::tokenizer<boost::char_separator<char>> tokens(params, boost::char_separator<char>(","));
+				const auto numOfTokens = std::distance(tokens.begin(), tokens.end());
+				if (numOfTokens < 1 || numOfTokens > 2) {
+					std::cerr << "ERROR: wrong number (expected 1 or 2) of simplification parameters found." << std::endl;
+					break;
+				}
+				try {
+					// Tolerance
+					boost::tokenizer<boost::char_separator<char>>::iterator token = tokens.begin();
+					simplifyToleranceMt = std::stod(*token);
+
+					// Max number of points
+					if (numOfTokens > 1) {
+						token++;
+						simplifyMaxPoints = std::stoul(*token);
+					}
+
+					simplify = true;
+				} catch (...) {
+					std::cerr << "ERROR: unable to parse simplification parameters." << std::endl;
+				}
+			}
+			break;
 		case 'p':
 			ac.DoNotCalculateArcsAndCirconferences();
 			break;
+		case 'f':
+			if (!hasValueAfter) std::cerr << "ERROR: arcs fitting tolerance not found." << std::endl;
+			else try {
+				if (!ac.SetArcsFittingTolerance(std::stod(argv[++i]))) std::cerr << "ERROR: arcs fitting tolerance not valid." << std::endl;
+			} catch (...) {
+				std::cerr << "ERROR: unable to parse arcs fitting tolerance." << std::endl;
+			}
+			break;
 		case 's':
 			ac.SetOpenAirCoodinatesInSeconds();
 			break;
@@ -173,6 +243,24 @@ int main(int argc, char *argv[]) {
 		case 't':
 			ac.ProcessTracksAsAirspaces();
 			break;
+		case 'g':
+			if (!hasValueAfter) std::cerr << "ERROR: arcs and circles resolution not found, using default value: " << ac.GetResolution() << " NM." << std::endl;
+			else try {
+				if (!ac.SetResolution(std::stod(argv[++i]))) std::cerr << "ERROR: arcs and circles resolution not valid, using default value: " << ac.GetResolution() << " NM." << std::endl;
+			} catch (...) {
+				std::cerr << "ERROR: unable to parse arcs and circles resolution, using default value: " << ac.GetResolution() << " NM." << std::endl;
+			}
+			break;
+		case 'z':
+			ac.CalculateSurfacesOnSphere();
+			break;
+		case 'c':
+			checkSelfIntersections = true;
+			break;
+		case 'r':
+			checkSelfIntersections = true;
+			repairSelfIntersections = true;
+			break;
 		case 'v':
 			std::cout << "AirspaceConverter version: " << VERSION << std::endl;
 			std::cout << "Compiled on " << __DATE__ << " at " << __TIME__ << std::endl;
@@ -188,6 +276,17 @@ int main(int argc, char *argv[]) {
 			std::cout << "https://www.alus.it/AirspaceConverter" << std::endl << std::endl;
 			if (argc == 2) return EXIT_SUCCESS;
 			break;
+		case '-': // --threads
+			if (strcmp(argv[i], "--threads") != 0) std::cerr << "Warning: Skipping unknown option: " << argv[i] << std::endl;
+			else if (!hasValueAfter) std::cerr << "ERROR: number of threads not found, using default value: " << AirspaceConverter::GetNumOfThreads() << std::endl;
+			else try {
+				const int threads = std::stoi(argv[++i]);
+				if (threads > 0) AirspaceConverter::SetNumOfThreads((unsigned int)threads);
+				else std::cerr << "ERROR: number of threads not valid, using default value: " << AirspaceConverter::GetNumOfThreads() << std::endl;
+			} catch (...) {
+				std::cerr << "ERROR: unable to parse number of threads, using default value: " << AirspaceConverter::GetNumOfThreads() << std::endl;
+			}
+			break;
 		default:
 			std::cerr << "Warning: Skipping unknown option: " << argv[i] << std::endl;
 			break;
@@ -207,6 +306,10 @@ int main(int argc, char *argv[]) {
 
 	bool result(false);
 
+	// Skip already while reading what the filters below would remove
+	if (altitudeLimitsAreSet) ac.PrefilterOnAltitudeLimits(limitLowAltitude, limitHiAltitude);
+	if (positionLimitsAreSet) ac.PrefilterOnLatLonLimits(topLat, bottomLat, leftLon, rightLon, clipOnPositionLimits);
+
 	// Load airspaces and waypoints
 	ac.LoadAirspaces();
 	ac.LoadWaypoints();
@@ -221,7 +324,19 @@ int main(int argc, char *argv[]) {
 	if (altitudeLimitsAreSet && !ac.FilterOnAltitudeLimits(limitLowAltitude, limitHiAltitude)) std::cerr << "ERROR: filter altitude limit are not valid." << std::endl;
 
 	// Apply position filter if required
-	if (positionLimitsAreSet && !ac.FilterOnLatLonLimits(topLat, bottomLat, leftLon, rightLon)) std::cerr << "ERROR: filter position limit bounds are not valid." << std::endl;
+	if (positionLimitsAreSet && !ac.FilterOnLatLonLimits(topLat, bottomLat, leftLon, rightLon, clipOnPositionLimits)) std::cerr << "ERROR: filter position limit bounds are not valid." << std::endl;
+
+	// Check self intersecting airspaces if required
+	if (checkSelfIntersections) ac.ValidateAirspaces(repairSelfIntersections);
+
+	// Merge the touching airspaces if required
+	if (dissolve) ac.DissolveAirspaces();
+
+	// Report the overlapping airspaces if required
+	if (!overlapsReportFile.empty()) ac.AnalyzeOverlaps(overlapsReportFile);
+
+	// Simplify the airspaces if required
+	if (simplify && !ac.SimplifyAirspaces(simplifyToleranceMt, simplifyMaxPoints)) std::cerr << "ERROR: simplification parameters are not valid." << std::endl;
 
 	// Convert!
 	result = ac.Convert();
@@ -0,0 +1,81 @@
+#!/bin/bash
+#============================================================================
+# AirspaceConverter
+# Web         : https://www.alus.it/AirspaceConverter
+# License     : GNU GPL v3
+#
+# This script is part of AirspaceConverter project
+#============================================================================
+# 'benchmarkLoadUnload' time repeated load and unload of the same airspaces and waypoints in one process, like in the GUI
+# Usage: benchmarkLoadUnload.sh [number of cycles] [number of airspaces] [number of waypoints]
+
+cycles=${1:-10}
+airspaces=${2:-5000}
+waypoints=${3:-50000}
+libdir=${LIBDIR:-../Release}
+dir=$(mktemp -d) || exit 1
+
+echo Generating $airspaces airspaces and $waypoints waypoints ...
+awk -v n=$airspaces -v w=$waypoints -v dir=$dir '
+function dm(v, width, sep) { # Degrees and decimal minutes, truncated to avoid rounding to 60 minutes
+	v = v < 0 ? -v : v
+	return sprintf("%0" width "d%s%06.3f", int(v), sep, int((v - int(v)) * 60000) / 1000)
+}
+BEGIN {
+	srand(1)
+	openair = dir "/benchmark.txt"
+	cup = dir "/benchmark.cup"
+	for (a = 0; a < n; a++) {
+		printf "AC R\nAN BENCHMARK %d\nAL GND\nAH FL%d\n", a, 50 + a % 100 > openair
+		clat = -60 + 120 * rand(); clon = -170 + 340 * rand()
+		for (i = 0; i < 200; i++) {
+			ang = 6.283185307179586 * i / 200
+			lat = clat + 0.5 * sin(ang); lon = clon + 0.5 * cos(ang)
+			printf "DP %s %s %s %s\n", dm(lat, 2, ":"), lat < 0 ? "S" : "N", dm(lon, 3, ":"), lon < 0 ? "W" : "E" > openair
+		}
+		printf "V X=%s %s %s %s\nDC 2\n\n", dm(clat, 2, ":"), clat < 0 ? "S" : "N", dm(clon, 3, ":"), clon < 0 ? "W" : "E" > openair
+	}
+	print "name,code,country,lat,lon,elev,style,rwdir,rwlen,freq,desc" > cup
+	for (i = 0; i < w; i++) {
+		lat = -60 + 120 * rand(); lon = -170 + 340 * rand()
+		printf "\"WP%d\",\"W%d\",XX,%s%s,%s%s,%dm,%d,,,,\"TOWER\"\n", i, i, dm(lat, 2, ""), lat < 0 ? "S" : "N", dm(lon, 3, ""), lon < 0 ? "W" : "E", int(2000 * rand()), 1 + i % 10 > cup
+	}
+}'
+
+echo Building the benchmark program ...
+cat > $dir/benchmark.cpp << 'EOF'
+#include "AirspaceConverter.hpp"
+#include <chrono>
+#include <iostream>
+
+int main(int argc, char *argv[]) {
+	if (argc != 4) return 1;
+	const int cycles = std::stoi(argv[3]);
+	AirspaceConverter::SetLogMessageFunction([](const std::string&) {});
+	AirspaceConverter::SetLogWarningFunction([](const std::string&) {});
+	AirspaceConverter converter;
+	std::chrono::duration<double> load(0), unload(0);
+	for (int i = 0; i < cycles; i++) {
+		const auto start = std::chrono::steady_clock::now();
+		converter.AddAirspaceFile(argv[1]);
+		converter.AddWaypointFile(argv[2]);
+		converter.LoadAirspaces();
+		converter.LoadWaypoints();
+		const auto loaded = std::chrono::steady_clock::now();
+		converter.UnloadAirspaces();
+		converter.UnloadWaypoints();
+		const auto unloaded = std::chrono::steady_clock::now();
+		load += loaded - start;
+		unload += unloaded - loaded;
+	}
+	std::cout << "Average load: " << 1000 * load.count() / cycles << " ms, average unload: " << 1000 * unload.count() / cycles << " ms" << std::endl;
+	return 0;
+}
+EOF
+g++ -std=c++23 -O2 -I../src $dir/benchmark.cpp -L$libdir -lairspaceconverter -Wl,-rpath,$(realpath $libdir) -o $dir/benchmark || exit 1
+
+echo Loading and unloading $cycles times ...
+$dir/benchmark $dir/benchmark.txt $dir/benchmark.cup $cycles
+
+rm -rf "${dir:?}"
+echo Done
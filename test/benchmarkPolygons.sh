@@ -0,0 +1,53 @@
+#!/bin/bash
+#============================================================================
+# AirspaceConverter
+# Web         : https://www.alus.it/AirspaceConverter
+# License     : GNU GPL v3
+#
+# This script is part of AirspaceConverter project
+#============================================================================
+# 'benchmarkPolygons' time the import of airspaces made of polygons with a lot of points
+# Usage: benchmarkPolygons.sh [number of airspaces] [number of points per airspace]
+
+airspaces=${1:-20}
+points=${2:-20000}
+converter=${CONVERTER:-../Release/airspaceconverter}
+dir=$(mktemp -d) || exit 1
+
+echo Generating $airspaces airspaces with $points points each ...
+awk -v n=$airspaces -v p=$points -v dir=$dir 'BEGIN {
+	srand(1)
+	openair = dir "/benchmark.txt"
+	kml = dir "/benchmark.kml"
+	printf "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<kml>\n<Document>\n" > kml
+	for (a = 0; a < n; a++) {
+		printf "AC D\nAN BENCHMARK %d\nAL GND\nAH FL100\n", a > openair
+		printf "<Placemark>\n<name>BENCHMARK %d</name>\n<ExtendedData><SchemaData>\n", a > kml
+		printf "<SimpleData name=\"Category\">D</SimpleData>\n<SimpleData name=\"Base\">GND</SimpleData>\n<SimpleData name=\"Top\">FL100</SimpleData>\n" > kml
+		printf "</SchemaData></ExtendedData>\n<Polygon>\n<extrude>1</extrude>\n<outerBoundaryIs><LinearRing><coordinates>\n" > kml
+		clat = 45 + (a % 10); clon = 7 + int(a / 10)
+		for (i = 0; i <= p; i++) {
+			ang = 6.283185307179586 * (i % p) / p
+			r = 1 + 0.1 * sin(7 * ang) + (i < p ? 0.001 * rand() : 0)
+			lat = clat + r * sin(ang); lon = clon + r * cos(ang)
+			if (i == 0) { firstLat = lat; firstLon = lon }
+			if (i == p) { lat = firstLat; lon = firstLon }
+			latD = int(lat); latM = (lat - latD) * 60
+			lonD = int(lon); lonM = (lon - lonD) * 60
+			if (i < p) printf "DP %02d:%06.3f N %03d:%06.3f E\n", latD, latM, lonD, lonM > openair
+			printf "%.7f,%.7f,%d\n", lon, lat, 3048 + i % 2 > kml # Not all at the same altitude, so checked for repeated points
+		}
+		print "" > openair
+		printf "</coordinates></LinearRing></outerBoundaryIs>\n</Polygon>\n</Placemark>\n" > kml
+	}
+	printf "</Document>\n</kml>\n" > kml
+}'
+
+echo Importing OpenAir ...
+time $converter -i $dir/benchmark.txt -o $dir/benchmark_openair.txt -p > /dev/null 2>&1
+
+echo Importing KML ...
+time $converter -i $dir/benchmark.kml -o $dir/benchmark_kml.txt -p > /dev/null 2>&1
+
+rm -rf "${dir:?}"
+echo Done
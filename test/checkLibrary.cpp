@@ -0,0 +1,397 @@
+//============================================================================
+// AirspaceConverter
+// Web         : https://www.alus.it/AirspaceConverter
+// Repository  : https://github.com/alus-it/AirspaceConverter.git
+// License     : GNU GPL v3
+//
+// This source file is part of AirspaceConverter project
+//============================================================================
+// Checks of the geometric functions of the library on small cases with known results
+
+#include "AirspaceConverter.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <utility>
+
+static int failed = 0;
+
+static void Check(const bool condition, const std::string& what) {
+	std::cout << (condition ? "OK: " : "FAILED: ") << what << std::endl;
+	if (!condition) failed++;
+}
+
+// Closed airspace with the given vertices, in degrees
+static Airspace MakeAirspace(const std::vector<std::pair<double, double>>& vertices) {
+	Airspace airspace(Airspace::R);
+	for (const std::pair<double, double>& v : vertices) airspace.AddPointLatLonOnly(v.first, v.second);
+	airspace.ClosePoints();
+	return airspace;
+}
+
+// Closed airspace around a pole, with the vertices at the given latitude every 30 degrees of longitude
+static Airspace MakeCap(const double lat) {
+	std::vector<std::pair<double, double>> vertices;
+	for (int lon = -165; lon < 180; lon += 30) vertices.push_back({ lat, lat > 0 ? lon : -lon });
+	return MakeAirspace(vertices);
+}
+
+static void CheckContains() {
+	const Airspace square(MakeAirspace({ {45, 10}, {45, 11}, {46, 11}, {46, 10} }));
+	Check(square.Contains(45.5, 10.5), "square contains its center");
+	Check(!square.Contains(45.5, 11.5), "square does not contain a point east of it");
+	Check(!square.Contains(46.5, 10.5), "square does not contain a point north of it");
+
+	// Concave: a U open to north
+	const Airspace u(MakeAirspace({ {45, 10}, {45, 11}, {46, 11}, {46, 10.7}, {45.3, 10.7}, {45.3, 10.3}, {46, 10.3}, {46, 10} }));
+	Check(u.Contains(45.5, 10.1), "U contains a point in the west arm");
+	Check(u.Contains(45.1, 10.5), "U contains a point in the base");
+	Check(!u.Contains(45.5, 10.5), "U does not contain a point between the arms");
+
+	// Across the antimeridian
+	const Airspace pacific(MakeAirspace({ {-10, 170}, {-10, -170}, {10, -170}, {10, 170} }));
+	Check(pacific.Contains(0, 180), "airspace across the antimeridian contains a point on it");
+	Check(pacific.Contains(0, -175), "airspace across the antimeridian contains a point west of it");
+	Check(pacific.Contains(0, 175), "airspace across the antimeridian contains a point east of it");
+	Check(!pacific.Contains(0, 0), "airspace across the antimeridian does not contain a point on the other side of the world");
+
+	// Around the poles, closed through the pole
+	const Airspace northCap(MakeCap(80)), southCap(MakeCap(-75));
+	Check(northCap.Contains(89.9, 0), "cap around the north pole contains a point near the pole");
+	Check(northCap.Contains(85, 100), "cap around the north pole contains a point inside it");
+	Check(northCap.Contains(85, 180) && northCap.Contains(85, -179.9), "cap around the north pole contains the points on the far side in longitude");
+	Check(!northCap.Contains(75, 0) && !northCap.Contains(75, 180), "cap around the north pole does not contain the points below it");
+	Check(!northCap.Contains(-85, 0), "cap around the north pole does not contain a point near the south pole");
+	Check(southCap.Contains(-89.9, 0) && southCap.Contains(-80, -120), "cap around the south pole contains the points inside it");
+	Check(!southCap.Contains(-70, 60) && !southCap.Contains(85, 0), "cap around the south pole does not contain the points above it");
+
+	// Many positions at once, as the single ones
+	const std::vector<Geometry::LatLon> positions { Geometry::LatLon(45.5, 10.1), Geometry::LatLon(45.5, 10.5), Geometry::LatLon(45.1, 10.5), Geometry::LatLon(44, 10.5) };
+	std::vector<bool> inside;
+	u.Contains(positions, inside);
+	bool same(inside.size() == positions.size());
+	for (size_t i = 0; same && i < positions.size(); i++) same = inside[i] == u.Contains(positions[i].Lat(), positions[i].Lon());
+	Check(same, "many positions at once give the same results as one by one");
+}
+
+static void CheckWithinLimits() {
+	const Airspace cap(MakeCap(80));
+	Check(cap.IsWithinLatLonLimits(Geometry::Limits(89, 85, 0, 10)), "cap around the pole is within limits inside it");
+	Check(cap.IsWithinLatLonLimits(Geometry::Limits(89, 85, 170, -170)), "cap around the pole is within limits inside it across the antimeridian");
+	Check(!cap.IsWithinLatLonLimits(Geometry::Limits(75, 70, 0, 10)), "cap around the pole is not within limits below it");
+	Check(!cap.IsWithinLatLonLimits(Geometry::Limits(-85, -89, 0, 10)), "cap around the pole is not within limits around the other pole");
+	const Airspace dipping(MakeAirspace({ {80, -165}, {80, -135}, {80, -105}, {80, -75}, {80, -45}, {80, -15}, {70, 15}, {80, 45}, {80, 75}, {80, 105}, {80, 135}, {80, 165} }));
+	Check(dipping.IsWithinLatLonLimits(Geometry::Limits(79, 76, 5, 25)), "cap around the pole is within limits reached only between their corners");
+	const Airspace square(MakeAirspace({ {40, 0}, {40, 20}, {50, 20}, {50, 0} }));
+	Check(square.IsWithinLatLonLimits(Geometry::Limits(46, 44, 9, 11)), "large square is within limits inside it");
+	Check(!square.IsWithinLatLonLimits(Geometry::Limits(46, 44, 21, 23)), "large square is not within limits east of it");
+
+	// The same from the spatial index of the converter
+	AirspaceConverter converter;
+	AirspaceConverter::SetLogMessageFunction([](const std::string&) {});
+	converter.AddAirspaceFile("data/cap.txt");
+	converter.LoadAirspaces();
+	std::vector<const Airspace*> found;
+	converter.FindAirspacesIn(Geometry::Limits(89, 85, 0, 10), found);
+	Check(found.size() == 1 && found.front()->GetName() == "NORTH POLE CAP", "only the north pole cap found in limits inside it");
+	converter.FindAirspacesIn(Geometry::Limits(-80, -89, -100, -90), found);
+	Check(found.size() == 1 && found.front()->GetName() == "SOUTH POLE CAP", "only the south pole cap found in limits inside it");
+	converter.FindAirspacesIn(Geometry::Limits(46, 44, 9, 11), found);
+	Check(found.size() == 1 && found.front()->GetName() == "LARGE SQUARE", "only the large square found in limits inside it");
+}
+
+// Area of the band between two meridians and two parallels on the sphere of mean radius [Km2]
+static double SphereBandArea(const double lat1, const double lat2, const double lon1, const double lon2) {
+	const double deg2rad = 3.1415926535897932384626433832795 / 180;
+	return 6371.0088 * 6371.0088 * (lon2 - lon1) * deg2rad * (std::sin(lat2 * deg2rad) - std::sin(lat1 * deg2rad));
+}
+
+static bool IsNear(const double value, const double expected, const double relTolerance) {
+	return std::fabs(value - expected) <= relTolerance * std::fabs(expected);
+}
+
+static void CheckSurface() {
+	const std::pair<double, double> squares[] = { {0, 10}, {45, 10}, {-60, 179} }; // South west corners of squares of 1 degree
+	for (const std::pair<double, double>& sw : squares) {
+		const double lat = sw.first, lon = sw.second, lon2 = lon + 1 > 180 ? lon + 1 - 360 : lon + 1;
+		const Airspace square(MakeAirspace({ {lat, lon}, {lat, lon2}, {lat + 1, lon2}, {lat + 1, lon} }));
+		const std::string where = " of the square at " + std::to_string(int(lat)) + "," + std::to_string(int(lon));
+		double area(0), perimeter(0), areaSphere(0), perimeterSphere(0);
+		square.CalculateSurface(area, perimeter);
+		square.CalculateSurface(areaSphere, perimeterSphere, true);
+		const double expected = SphereBandArea(lat, lat + 1, lon, lon + 1);
+		Check(IsNear(areaSphere, expected, 0.0005), "area on the sphere" + where + " as expected");
+		Check(IsNear(areaSphere, area, 0.01), "area on the sphere" + where + " close to the one on WGS84");
+		Check(IsNear(perimeterSphere, perimeter, 0.01), "perimeter on the sphere" + where + " close to the one on WGS84");
+	}
+}
+
+static void CheckStringPool() {
+	StringPool::Purge(); // The texts left by the previous checks
+	const size_t before = StringPool::Size();
+	{
+		Airspace airspace(MakeAirspace({ {45, 10}, {45, 11}, {46, 11} }));
+		airspace.SetName("Text used only by this check");
+		const Airspace copy(airspace.Clone());
+		Check(copy.GetInternedName() == airspace.GetInternedName(), "copies of a name share the same text");
+		StringPool::Purge();
+		Check(StringPool::Size() == before + 1, "a text still used is kept in the pool");
+	}
+	StringPool::Purge();
+	Check(StringPool::Size() <= before, "a text no longer used is released from the pool");
+}
+
+static void CheckArenaLifetime() {
+	AirspaceConverter converter;
+	AirspaceConverter::SetLogMessageFunction([](const std::string&) {});
+	converter.AddAirspaceFile("data/clip.txt");
+	converter.LoadAirspaces();
+	std::vector<const Airspace*> found;
+	converter.FindAirspacesAt(45.25, 10.25, found);
+	if (found.size() != 1 || found.front()->GetNumberOfGeometries() == 0) {
+		Check(false, "airspace with geometries read from the file");
+		return;
+	}
+	Airspace clone(found.front()->Clone());
+	converter.UnloadAirspaces();
+	converter.AddAirspaceFile("data/clip.txt");
+	converter.LoadAirspaces(); // Reuse the memory released
+	const Geometry* geometry = clone.GetGeometryAt(0);
+	Check(geometry != nullptr && std::fabs(geometry->GetCenterPoint().Lat() - (45 + 10 / 60.0)) < 1e-6, "geometries of a clone still valid after unloading the airspaces");
+}
+
+static void CheckParallel() {
+	std::atomic<bool> working(true);
+	std::thread resizer([&working]() { // Change the number of threads while working
+		for (unsigned int threads = 1; working; threads = threads % 6 + 1) AirspaceConverter::SetNumOfThreads(threads);
+	});
+	std::atomic<int> wrong(0);
+	std::vector<std::thread> callers;
+	for (int c = 0; c < 4; c++) callers.emplace_back([&wrong]() {
+		for (int k = 0; k < 100; k++) {
+			std::vector<int> sums(1000, 0);
+			Parallel::For(sums.size(), [&sums](const size_t i) {
+				std::vector<int> ones(10, 0);
+				Parallel::For(ones.size(), [&ones](const size_t j) { ones[j] = 1; }); // Nested
+				for (const int one : ones) sums[i] += one;
+			});
+			for (const int sum : sums) if (sum != 10) wrong++;
+		}
+	});
+	for (std::thread& caller : callers) caller.join();
+	working = false;
+	resizer.join();
+	AirspaceConverter::SetNumOfThreads(0);
+	Check(wrong == 0, "parallel work from more threads while changing the number of threads");
+}
+
+static void CheckPrefilters() {
+	AirspaceConverter converter;
+	converter.PrefilterOnLatLonLimits(46, 45, 10, 11);
+	converter.AddAirspaceFile("data/clip.txt");
+	converter.LoadAirspaces();
+	const unsigned long filtered = converter.GetNumOfAirspaces();
+	converter.UnloadAirspaces();
+	converter.ClearPrefilters();
+	converter.AddAirspaceFile("data/clip.txt");
+	converter.LoadAirspaces();
+	Check(filtered > 0 && converter.GetNumOfAirspaces() > filtered, "airspaces no longer prefiltered after clearing the prefilters");
+}
+
+static void CheckCategoriesFilter() {
+	AirspaceConverter converter;
+	converter.AddAirspaceFile("data/overlaps.txt");
+	converter.LoadAirspaces();
+	const unsigned long all = converter.GetNumOfAirspaces();
+	Check(converter.FilterOnCategories("Danger area", true) && converter.GetNumOfAirspaces() == 1, "only the airspaces of the category included kept after loading");
+	AirspaceConverter::SetLogErrorFunction([](const std::string&) {}); // The unknown category is expected
+	Check(!converter.FilterOnCategories("R,NOTHING") && converter.GetNumOfAirspaces() == 1, "unknown category refused without filtering");
+	converter.UnloadAirspaces();
+	converter.ClearCategoriesFilter();
+	converter.AddAirspaceFile("data/overlaps.txt");
+	converter.LoadAirspaces();
+	Check(all > 1 && converter.GetNumOfAirspaces() == all, "airspaces no longer filtered on category after clearing the filter");
+}
+
+// Heights in meters of the bases and tops of the loaded airspaces, in iteration order
+static std::vector<double> Altitudes(AirspaceConverter& converter) {
+	std::vector<const Airspace*> all;
+	converter.FindAirspacesIn(Geometry::Limits(), all);
+	std::vector<double> altitudes;
+	for (const Airspace* airspace : all) {
+		altitudes.push_back(airspace->GetBaseAltitude().GetAltMt());
+		altitudes.push_back(airspace->GetTopAltitude().GetAltMt());
+	}
+	return altitudes;
+}
+
+static std::vector<double> AltitudesLoadedWithQNH(const double QNHhPa) {
+	AirspaceConverter converter;
+	converter.SetQNH(QNHhPa);
+	converter.AddAirspaceFile("data/overlaps.txt");
+	converter.LoadAirspaces();
+	return Altitudes(converter);
+}
+
+// Heights of the limits and total number of points of the airspaces with arcs loaded with the given settings
+static std::pair<std::vector<double>, size_t> LoadArcs(const double QNHhPa, const double resolutionNM) {
+	AirspaceConverter converter;
+	converter.SetQNH(QNHhPa);
+	converter.SetResolution(resolutionNM);
+	converter.AddAirspaceFile("data/arcs_found.txt");
+	converter.LoadAirspaces();
+	std::vector<const Airspace*> all;
+	converter.FindAirspacesIn(Geometry::Limits(), all);
+	size_t points(0);
+	for (const Airspace* airspace : all) points += airspace->GetNumberOfPoints();
+	return { Altitudes(converter), points };
+}
+
+static void CheckConvertersOnThreads() {
+	const std::pair<std::vector<double>, size_t> fine(LoadArcs(980, 0.1)), coarse(LoadArcs(1030, 1));
+	std::atomic<int> wrong(0);
+	std::thread first([&]() { for (int k = 0; k < 20; k++) if (LoadArcs(980, 0.1) != fine) wrong++; });
+	std::thread second([&]() { for (int k = 0; k < 20; k++) if (LoadArcs(1030, 1) != coarse) wrong++; });
+	first.join();
+	second.join();
+	Check(fine.first != coarse.first && fine.second > coarse.second && wrong == 0, "converters with different QNH and resolution on separate threads like one after the other");
+}
+
+static void CheckQNH() {
+	const std::vector<double> standard(AltitudesLoadedWithQNH(Altitude::QNE)), low(AltitudesLoadedWithQNH(980));
+	AirspaceConverter converter;
+	converter.AddAirspaceFile("data/overlaps.txt");
+	converter.LoadAirspaces();
+	Check(!standard.empty() && standard != low, "flight levels at different heights with a different QNH");
+	converter.SetQNH(980);
+	Check(Altitudes(converter) == low, "QNH set after loading like set before");
+	converter.SetQNH(Altitude::QNE);
+	Check(Altitudes(converter) == standard, "QNH set back after loading like never changed");
+}
+
+// Names of the airspaces found, sorted, to compare them with the ones found scanning all the airspaces
+static std::vector<std::string> Names(const std::vector<const Airspace*>& airspaces) {
+	std::vector<std::string> names;
+	for (const Airspace* airspace : airspaces) names.push_back(airspace->GetName());
+	std::sort(names.begin(), names.end());
+	return names;
+}
+
+// OpenAir coordinate from whole minutes
+static std::string OpenAirCoordinate(const int minutes, const bool isLat) {
+	char text[20];
+	const int m = std::abs(minutes);
+	std::snprintf(text, sizeof(text), isLat ? "%02d:%02d:00 %c" : "%03d:%02d:00 %c", m / 60, m % 60, isLat ? (minutes < 0 ? 'S' : 'N') : (minutes < 0 ? 'W' : 'E'));
+	return text;
+}
+
+static void CheckFindAirspaces() {
+	// Random hexagons, one every four around the antimeridian, and a cap around the north pole over all the longitudes
+	std::mt19937 random(1);
+	std::vector<std::vector<std::pair<int, int>>> polygons; // Latitude and longitude [min]
+	for (int a = 0; a < 200; a++) {
+		const int lat = std::uniform_int_distribution<int>(-70 * 60, 60 * 60)(random);
+		const int lon = a % 4 == 0 ? 180 * 60 + std::uniform_int_distribution<int>(-120, 120)(random) : std::uniform_int_distribution<int>(-180 * 60, 180 * 60)(random);
+		const int size = std::uniform_int_distribution<int>(10, 600)(random);
+		std::vector<std::pair<int, int>> hexagon;
+		for (int v = 0; v < 6; v++) {
+			const double angle = v * 3.1415926535897932384626433832795 / 3;
+			int vertexLon = lon + (int)(size * std::cos(angle));
+			if (vertexLon >= 180 * 60) vertexLon -= 360 * 60; // OpenAir longitudes must be less than 180 degrees
+			else if (vertexLon <= -180 * 60) vertexLon += 360 * 60;
+			if (vertexLon == -180 * 60) vertexLon++;
+			hexagon.push_back({ lat + (int)(size * std::sin(angle)), vertexLon });
+		}
+		polygons.push_back(hexagon);
+	}
+	std::vector<std::pair<int, int>> cap;
+	for (int lon = -170; lon <= 170; lon += 10) cap.push_back({ 80 * 60, lon * 60 });
+	polygons.push_back(cap);
+
+	// The same airspaces loaded by the converter and kept here to scan them all
+	const std::filesystem::path file(std::filesystem::temp_directory_path() / "checkLibraryFind.txt");
+	std::vector<Airspace> all;
+	{
+		std::ofstream openAir(file);
+		for (size_t a = 0; a < polygons.size(); a++) {
+			openAir << "AC R\nAN A" << a << "\nAL GND\nAH FL100\n";
+			std::vector<std::pair<double, double>> vertices;
+			for (const std::pair<int, int>& v : polygons[a]) {
+				openAir << "DP " << OpenAirCoordinate(v.first, true) << " " << OpenAirCoordinate(v.second, false) << "\n";
+				vertices.push_back({ v.first / 60.0, v.second / 60.0 });
+			}
+			openAir << "\n";
+			all.push_back(MakeAirspace(vertices));
+			all.back().SetName("A" + std::to_string(a));
+		}
+	}
+	AirspaceConverter converter;
+	AirspaceConverter::SetLogMessageFunction([](const std::string&) {});
+	AirspaceConverter::SetLogWarningFunction([](const std::string&) {});
+	converter.AddAirspaceFile(file.string());
+	converter.LoadAirspaces();
+	std::filesystem::remove(file);
+	Check(converter.GetNumOfAirspaces() == all.size(), "all the airspaces to find loaded");
+
+	// Points, also close to the antimeridian and the poles
+	size_t mismatches(0), found(0);
+	std::vector<const Airspace*> result, expected;
+	for (int p = 0; p < 5000; p++) {
+		const double lat = std::uniform_real_distribution<double>(-90, 90)(random);
+		const double lon = p % 4 == 0 ? (p % 8 == 0 ? 1 : -1) * std::uniform_real_distribution<double>(177, 180)(random) : std::uniform_real_distribution<double>(-180, 180)(random);
+		converter.FindAirspacesAt(lat, lon, result);
+		expected.clear();
+		for (const Airspace& airspace : all) if (airspace.Contains(lat, lon)) expected.push_back(&airspace);
+		if (Names(result) != Names(expected)) mismatches++;
+		found += result.size();
+	}
+	Check(found > 0 && mismatches == 0, "airspaces found at the points like scanning all of them");
+
+	// Areas, also across the antimeridian and over all the longitudes
+	std::vector<Geometry::Limits> areas = { Geometry::Limits(90, -90, -180, 180), Geometry::Limits(85, 65, -180, 180), Geometry::Limits(10, -10, 170, -170), Geometry::Limits(-40, -60, 179, -179) };
+	for (int a = 0; a < 500; a++) {
+		const double bottom = std::uniform_real_distribution<double>(-90, 80)(random), top = std::min(90.0, bottom + std::uniform_real_distribution<double>(0.1, 20)(random));
+		const double left = std::uniform_real_distribution<double>(-180, 180)(random);
+		double right = left + std::uniform_real_distribution<double>(0.1, 40)(random);
+		if (right > 180) right -= 360; // Across the antimeridian
+		areas.push_back(Geometry::Limits(top, bottom, left, right));
+	}
+	mismatches = found = 0;
+	size_t acrossFound(0);
+	for (const Geometry::Limits& limits : areas) {
+		if (!limits.IsValid()) continue;
+		converter.FindAirspacesIn(limits, result);
+		expected.clear();
+		for (const Airspace& airspace : all) if (airspace.IsWithinLatLonLimits(limits)) expected.push_back(&airspace);
+		if (Names(result) != Names(expected)) mismatches++;
+		found += result.size();
+		if (limits.IsAcrossAntiGreenwich()) acrossFound += result.size();
+	}
+	Check(found > 0 && acrossFound > 0 && mismatches == 0, "airspaces found in the areas like scanning all of them");
+	converter.FindAirspacesIn(Geometry::Limits(90, -90, -180, 180), result);
+	Check(result.size() == all.size(), "all the airspaces found in the whole world");
+	converter.FindAirspacesIn(Geometry::Limits(81, 79, -180, 180), result);
+	Check(result.size() == 1 && result.front()->GetName() == "A" + std::to_string(all.size() - 1), "only the cap around the pole found in a band over all the longitudes");
+}
+
+int main() {
+	CheckContains();
+	CheckWithinLimits();
+	CheckSurface();
+	CheckStringPool();
+	CheckArenaLifetime();
+	CheckParallel();
+	CheckPrefilters();
+	CheckCategoriesFilter();
+	CheckQNH();
+	CheckConvertersOnThreads();
+	CheckFindAirspaces();
+	std::cout << "Failed: " << failed << std::endl;
+	return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,22 @@
+#!/bin/bash
+#============================================================================
+# AirspaceConverter
+# Web         : https://www.alus.it/AirspaceConverter
+# License     : GNU GPL v3
+#
+# This script is part of AirspaceConverter project
+#============================================================================
+# 'checkLibrary' build and run the checks of the geometric functions of the library
+# Usage: checkLibrary.sh (the directory of the library can be set with LIBDIR, by default ../Release)
+
+libdir=$(realpath ${LIBDIR:-../Release})
+cd "$(dirname "$0")" || exit 1
+dir=$(mktemp -d) || exit 1
+
+echo Building the checks ...
+g++ -std=c++23 -I../src checkLibrary.cpp -L$libdir -lairspaceconverter -Wl,-rpath,$libdir -o $dir/checkLibrary || exit 1
+
+$dir/checkLibrary
+result=$?
+rm -rf "${dir:?}"
+exit $result
@@ -0,0 +1,59 @@
+#!/bin/bash
+#============================================================================
+# AirspaceConverter
+# Web         : https://www.alus.it/AirspaceConverter
+# License     : GNU GPL v3
+#
+# This script is part of AirspaceConverter project
+#============================================================================
+# 'checkOutputs' convert the small cases in the data directory and compare the results with the expected ones
+# Usage: checkOutputs.sh (the converter to check can be set with CONVERTER, by default ../Release/airspaceconverter)
+
+converter=$(realpath ${CONVERTER:-../Release/airspaceconverter})
+cd "$(dirname "$0")/data" || exit 1
+dir=$(mktemp -d) || exit 1
+failed=0
+
+# Each case: input file, options and expected output; an @ in the options is the output to compare instead of the one given with -o
+while IFS='|' read -r input options expected; do
+	[ -z "$input" ] && continue
+	output=$dir/$expected
+	eval "args=(${options//@/$output})" # The options may be quoted to contain spaces
+	if [[ "$options" == *@* ]]; then
+		$converter -i $input "${args[@]}" -o $dir/ignored.txt > $dir/log.txt 2>&1
+	else
+		$converter -i $input "${args[@]}" -o $output > $dir/log.txt 2>&1
+	fi
+	# The comments of the header contain the date of the conversion
+	if diff <(grep -v '^\*' $expected | tr -d '\r') <(grep -v '^\*' $output 2>/dev/null | tr -d '\r') > $dir/diff.txt; then
+		echo "OK: $input $options"
+	else
+		echo "FAILED: $input $options"
+		cat $dir/log.txt $dir/diff.txt
+		failed=$((failed + 1))
+	fi
+done << 'CASES'
+normalize.txt|-p|normalize_expected.txt
+selfIntersecting.txt|-c -p|selfIntersecting_checked.txt
+selfIntersecting.txt|-r -p|selfIntersecting_repaired.txt
+simplify.txt|-x 300 -p|simplify_tolerance.txt
+simplify.txt|-x 0,8 -p|simplify_maxPoints.txt
+simplify.txt|-x 300,12 -p|simplify_both.txt
+arcs.aip||arcs_found.txt
+arcs.aip|-f 10|arcs_fitted.txt
+arcs_found.txt|-g 1 -p|arcs_resolution.txt
+clip.txt|-l 46,45,10,11 -p|clip_filtered.txt
+clip.txt|-l 46,45,10,11 -k -p|clip_clipped.txt
+clip.txt|-l 46,45,179,-179 -k -p|clip_antimeridian.txt
+cap.txt|-l 89,85,0,10 -p|cap_filtered.txt
+cap.txt|-l -80,-89,-100,-90 -k -p|cap_clipped.txt
+dissolve.txt|-j -p|dissolve_merged.txt
+overlaps.txt|-e @|overlaps_report.csv
+overlaps.txt|-n R -p|overlaps_excluded.txt
+overlaps.txt|-y "restricted area, FIR" -p|overlaps_included.txt
+overlaps.txt|-n NOTHING -p|overlaps_unknown.txt
+CASES
+
+rm -rf "${dir:?}"
+echo Failed: $failed
+[ $failed -eq 0 ]